@@ -1,6 +1,8 @@
 #pragma once
 
 #include <shared_mutex>
+#include <atomic>
+#include <thread>
 #include <map>
 #include <unordered_map>
 #include <set>
@@ -8,10 +10,21 @@
 #include <functional>
 #include <typeindex>
 #include <cassert>
+#include <span>
+#include <array>
+#include <optional>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <new>
+#include <string>
+#include <mutex>
+#include <condition_variable>
 
 namespace vecs {
 
-    using Mutex_t = std::shared_mutex; ///< Shared mutex type
     using namespace std::chrono_literals;
 
 	template<typename T>
@@ -29,18 +42,65 @@ namespace vecs {
 	template <typename> struct is_tuple : std::false_type {};
 	template <typename ...Ts> struct is_tuple<std::tuple<Ts...>> : std::true_type {};
 
+	/// @brief Mark a component type as read mostly by specializing this trait to std::true_type. In parallel mode,
+	/// Registry::Get and views read values of such components optimistically, guarded by the sequence lock of the
+	/// archetype instead of a lock. Readers retry if a write happened meanwhile. Read mostly components must be trivially 
+	/// copyable, and must be written with Put() or by assigning to a Ref, not through references returned by Ref.
+	template<typename T>
+	struct is_read_mostly : std::false_type {};
+
 	template<typename... Ts>
 	struct Yes {};
 
 	template<typename... Ts>
 	struct No {};
 
-    /// @brief Turn a type into a hash.
+	/// @brief Wrapper for inserting a double buffered component. The archetype stores such a component in two buffers,
+	/// the current and the previous one. Registry::SwapBuffers() swaps them at frame end by flipping two pointers.
+	/// Systems read last frame's values as Prev<T> and write this frame's values as Cur<T>. Putting a DoubleBuffered<T>
+	/// value writes the current buffer, inserting it writes both buffers.
+	template<typename T>
+	struct DoubleBuffered {
+		T m_value; ///< The component value.
+		operator const T&() const { return m_value; }
+	};
+
+	template<typename T>
+	struct Cur {}; ///< Access the current buffer of a DoubleBuffered<T> component.
+
+	template<typename T>
+	struct Prev {}; ///< Access the previous buffer of a DoubleBuffered<T> component.
+
+	/// @brief Constructor arguments of a component value of type T, which is constructed in place in its column,
+	/// see Registry::Emplace().
+	template<typename T, typename Tuple>
+	struct InPlace {
+		Tuple m_args; ///< The constructor arguments.
+	};
+
+	/// @brief Map an access type to the type of the column storing it, and to the value type.
+	template<typename T> struct column_of { using column_t = T; using value_t = T; };
+	template<typename T> struct column_of<Cur<T>> { using column_t = DoubleBuffered<T>; using value_t = T; };
+	template<typename T> struct column_of<Prev<T>> { using column_t = DoubleBuffered<T>; using value_t = T; };
+	template<typename T, typename Tuple> struct column_of<InPlace<T, Tuple>> { using column_t = T; using value_t = T; };
+
+	template<typename T>
+	using column_t = typename column_of<std::decay_t<T>>::column_t; ///< Type of the column storing T.
+
+	template<typename T>
+	using component_value_t = typename column_of<std::decay_t<T>>::value_t; ///< Type of the values of T.
+
+	/// @brief Type of the values of one entity read by Registry::GetMany(), the value if there is one type, else a tuple.
+	template<typename... Ts>
+	using gather_t = std::conditional_t< sizeof...(Ts) == 1, 
+		component_value_t<std::tuple_element_t<0, std::tuple<Ts...>>>, std::tuple<component_value_t<Ts>...> >;
+
+    /// @brief Turn a type into a hash. Cur<T> and Prev<T> have the hash of DoubleBuffered<T>.
     /// @tparam T The type to hash.
     /// @return The hash of the type.
     template<typename T>
 	inline auto Type() -> std::size_t {
-		return std::type_index(typeid(T)).hash_code();
+		return std::type_index(typeid(column_t<T>)).hash_code();
 	}
 
     /// @brief Compute the hash of a list of hashes. If stored in a vector, make sure that hashes are sorted.
@@ -70,9 +130,146 @@ namespace vecs {
 		}
 		return seed;
 	}
+
+	/// @brief Combine a hash value into a seed. The result depends on the order of the combined values.
+	/// @param seed The seed.
+	/// @param v The hash value to combine.
+	/// @return The new seed.
+	inline size_t HashCombine( size_t seed, size_t v ) {
+		return seed ^ (v + 0x9e3779b97f4a7c15ull + (seed<<6) + (seed>>2));
+	}
+
+	/// @brief Hash a block of bytes. The bytes are read as 64 bit words into four independent lanes, 
+	/// so the compiler can vectorize the main loop. The result is deterministic for the same bytes.
+	/// @param data Pointer to the bytes.
+	/// @param size Number of bytes.
+	/// @param seed The seed.
+	/// @return The hash of the bytes.
+	inline size_t HashBytes( const void* data, size_t size, size_t seed ) {
+		const uint64_t K = 0x9e3779b97f4a7c15ull;
+		auto ptr = static_cast<const unsigned char*>(data);
+		uint64_t lanes[4] = { seed, seed ^ K, seed + K, seed - K };
+		size_t i = 0;
+		for( ; i + sizeof(lanes) <= size; i += sizeof(lanes) ) {
+			uint64_t words[4];
+			std::memcpy(words, ptr + i, sizeof(words));
+			for( int l = 0; l < 4; ++l ) { lanes[l] = (lanes[l] ^ words[l]) * K; lanes[l] ^= lanes[l] >> 32; }
+		}
+		uint64_t hash = size;
+		for( int l = 0; l < 4; ++l ) { hash = (hash ^ lanes[l]) * K; }
+		for( ; i < size; ++i ) { hash = (hash ^ ptr[i]) * 0x100000001b3ull; } //tail bytes
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	/// @brief A pool of worker threads for ParallelFor(). The threads are created once and sleep between jobs. 
+	/// One job runs at a time, the calling thread takes part in it.
+	class WorkerPool {
+
+		/// @brief A job, all indices 0 to m_size-1 are handed out to the threads one by one.
+		struct Job {
+			void (*m_call)(void* fun, size_t i);	//calls the function of the job
+			void* m_fun;							//the function
+			size_t m_size;							//number of indices
+			std::atomic<size_t> m_next{0};			//next index to hand out
+		};
+
+	public:
+		/// @brief Constructor, creates the worker threads.
+		/// @param threads The number of worker threads, not counting the calling thread.
+		WorkerPool(size_t threads) {
+			for( size_t t = 0; t < threads; ++t ) { m_threads.emplace_back( [this](){ Loop(); } ); }
+		}
+
+		/// @brief Destructor, stops and joins the worker threads.
+		~WorkerPool() {
+			{ std::lock_guard lock(m_mutex); m_stop = true; }
+			m_wake.notify_all();
+		}
+
+		/// @brief Get the pool of the program, with one worker for each hardware thread but one.
+		/// @return The pool.
+		static auto Get() -> WorkerPool& {
+			static WorkerPool pool{ std::max(1u, std::thread::hardware_concurrency()) - 1 };
+			return pool;
+		}
+
+		/// @brief Get the number of threads that work on a job, including the calling thread.
+		auto Threads() const -> size_t { return m_threads.size() + 1; }
+
+		/// @brief true if the calling thread is running a job. Jobs must not start nested jobs, they would deadlock.
+		static auto InJob() -> bool { return t_inJob; }
+
+		/// @brief Call a function for all indices 0 to n-1, using all threads of the pool.
+		/// @param n The number of indices.
+		/// @param fun The function, called with the index.
+		template<typename F>
+		void Run( size_t n, F& fun ) {
+			std::lock_guard run(m_runMutex); //one job at a time
+			Job job{ [](void* f, size_t i){ (*static_cast<F*>(f))(i); }, const_cast<void*>(static_cast<const void*>(&fun)), n };
+			{ std::lock_guard lock(m_mutex); m_job = &job; ++m_generation; }
+			m_wake.notify_all();
+			Work(job);
+			std::unique_lock lock(m_mutex);
+			m_job = nullptr; //workers that wake up late do not join anymore
+			m_done.wait(lock, [&](){ return m_busy == 0; });
+		}
+
+	private:
+		/// @brief Hand out indices of a job to the calling thread until all are taken.
+		static void Work(Job& job) {
+			t_inJob = true;
+			for( size_t i = job.m_next++; i < job.m_size; i = job.m_next++ ) { job.m_call(job.m_fun, i); }
+			t_inJob = false;
+		}
+
+		/// @brief Main loop of a worker thread, waits for jobs and works on them.
+		void Loop() {
+			size_t generation = 0;
+			std::unique_lock lock(m_mutex);
+			while( true ) {
+				m_wake.wait(lock, [&](){ return m_stop || m_generation != generation; });
+				if( m_stop ) return;
+				generation = m_generation;
+				if( !m_job ) continue;
+				Job& job = *m_job;
+				++m_busy;
+				lock.unlock();
+				Work(job);
+				lock.lock();
+				if( --m_busy == 0 ) m_done.notify_one();
+			}
+		}
+
+		std::mutex m_runMutex;				///< Serializes jobs.
+		std::mutex m_mutex;					///< Protects the job state below.
+		std::condition_variable m_wake;		///< Wakes the workers for a new job or to stop.
+		std::condition_variable m_done;		///< Wakes the caller when the last worker left the job.
+		Job* m_job{nullptr};				///< The current job, or nullptr.
+		size_t m_generation{0};				///< Number of jobs started so far.
+		size_t m_busy{0};					///< Number of workers working on the current job.
+		bool m_stop{false};					///< If true, the workers stop.
+		std::vector<std::jthread> m_threads; ///< The worker threads, destroyed first.
+		inline static thread_local bool t_inJob = false; ///< true while the thread works on a job.
+	};
+
+	/// @brief Call a function for all indices 0 to n-1 in parallel on the threads of the WorkerPool. The calling 
+	/// thread takes part in the work. Small loops and loops started from within a job run on the calling thread.
+	/// The function must be thread safe, the order of the calls is not defined.
+	/// @param n The number of indices.
+	/// @param fun The function, called with the index.
+	inline void ParallelFor( size_t n, auto&& fun ) {
+		if( n < 2 || WorkerPool::InJob() || WorkerPool::Get().Threads() <= 1 ) { 
+			for( size_t i = 0; i < n; ++i ) { fun(i); } 
+			return; 
+		}
+		WorkerPool::Get().Run(n, fun);
+	}
 }
 
-#if !defined(REGISTRYTYPE_SEQUENTIAL) || !defined(REGISTRYTYPE_PARALLEL)
+#if !defined(REGISTRYTYPE_SEQUENTIAL) && !defined(REGISTRYTYPE_PARALLEL)
 	#define REGISTRYTYPE_SEQUENTIAL
 #endif
 
@@ -82,6 +279,16 @@ namespace vecs {
 	using Size_t = std::atomic<std::size_t>;
 #endif
 
+/// @brief Hint the CPU to load the cache line holding an address. Invalid addresses and nullptr do no harm.
+#if defined(__GNUC__) || defined(__clang__)
+	#define VECS_PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#define VECS_PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#else
+	#define VECS_PREFETCH(addr) ((void)(addr))
+#endif
+
 #include <VTLL.h>
 #include <VSTY.h>
 #include "VECSHandle.h"
@@ -89,4 +296,8 @@ namespace vecs {
 #include "VECSVector.h"
 #include "VECSSlotMap.h"
 #include "VECSArchetype.h"
+#include "VECSArchetypeMap.h"
+#include "VECSIndex.h"
+#include "VECSEvent.h"
+#include "VECSTimingWheel.h"
 #include "VECSRegistry.h"
@@ -18,6 +18,12 @@ namespace vecs {
 		struct ArchetypeAndIndex {
 			Archetype* m_arch;	//pointer to the archetype
 			size_t m_index;			//index of the entity in the archetype
+
+			/// @brief Store another pair field by field, so that optimistic readers can load the fields concurrently.
+			void Store(const ArchetypeAndIndex& other) {
+				StoreRelease(m_index, other.m_index);
+				StoreRelease(m_arch, other.m_arch);
+			}
 		};	
 
 		/// @brief Constructor, creates the archetype.
@@ -32,9 +38,14 @@ namespace vecs {
 		/// @return The index of the entity in the archetype.
 		template<typename... Ts>
 		size_t Insert(Handle handle, Ts&& ...values ) {
-			assert( m_maps.size() == sizeof...(Ts) + 1 );
+			assert( m_maps.size() >= sizeof...(Ts) + 1 );
 			assert( (m_maps.contains(Type<Ts>()) && ...) );
 			(AddValue( std::forward<Ts>(values) ), ...); //insert all components, get index of the handle
+			if( m_maps.size() > sizeof...(Ts) + 1 ) { //runtime components get default values
+				for( auto& [ti, map] : m_maps ) { 
+					if( ti != Type<Handle>() && ((ti != Type<Ts>()) && ...) ) { map->push_back(); } 
+				}
+			}
 			return AddValue( handle ); //insert the handle
 		}
 
@@ -56,23 +67,64 @@ namespace vecs {
 		/// @param archIndex The index of the entity in the archetype.
 		/// @return The component value.
 		template<typename U>
-		[[nodiscard]] auto Get(size_t archIndex) -> U& {
+		[[nodiscard]] auto Get(size_t archIndex) -> component_value_t<U>& {
 			using T = std::decay_t<U>;
 			assert( m_maps.contains(Type<T>()) );
 			assert( m_maps[Type<T>()]->size() > archIndex );
 			return (*Map<U>())[archIndex]; //Map<U>() decays the type
 		}
 
+		/// @brief Read a component value of an entity. Unlike Get(), this never unshares a segment that is 
+		/// shared with a snapshot.
+		/// @tparam U The type of the component.
+		/// @param archIndex The index of the entity in the archetype.
+		/// @return Const reference to the component value.
+		template<typename U>
+		[[nodiscard]] auto Read(size_t archIndex) -> const component_value_t<U>& {
+			assert( m_maps.contains(Type<std::decay_t<U>>()) );
+			return std::as_const(*Map<U>())[archIndex];
+		}
+
 		/// @brief Get component values of an entity.
 		/// @tparam ...Ts Types of the components to get.
 		/// @param handle Handle of the entity.
 		/// @return A tuple of the component values.
 		template<typename... Ts>
 			requires (sizeof...(Ts) > 1)
-		[[nodiscard]] auto Get(size_t archIndex) -> std::tuple<Ts&...> {
+		[[nodiscard]] auto Get(size_t archIndex) -> std::tuple<component_value_t<Ts>&...> {
 			assert( (m_maps.contains(Type<Ts>()) && ...) );
 			//assert( (m_maps[Type<Ts>()]->size() > archIndex && ...) );
-			return std::tuple<std::decay_t<Ts>&...>{ (*Map<std::decay_t<Ts>>())[archIndex]... };
+			return std::tuple<component_value_t<Ts>&...>{ (*Map<std::decay_t<Ts>>())[archIndex]... };
+		}
+
+		/// @brief One attempt to read component values optimistically, see SeqLock. 
+		/// @tparam ...Ts Types of the components, must be trivially copyable.
+		/// @param archIndex The index of the entity in the archetype.
+		/// @param seq The sequence number returned by GetSeqLock().ReadBegin().
+		/// @param values Receives the values. If the entity is not in the archetype anymore, they are value initialized.
+		/// @return true if the values are consistent, false if a write happened meanwhile and the read must be retried.
+		template<typename... Ts>
+		bool TryRead(size_t archIndex, size_t seq, std::tuple<component_value_t<Ts>...>& values) {
+			static_assert( (std::is_trivially_copyable_v<component_value_t<Ts>> && ...), "Read mostly components must be trivially copyable!" );
+			std::tuple<component_value_t<Ts>*...> ptrs{ Map<Ts>()->ReadAddress(archIndex)... };
+			if( m_seqLock.ReadRetry(seq) ) return false; //pointers point to valid memory, but maybe not to the entity
+			auto fun = [&]<size_t... Is>(std::index_sequence<Is...>) {
+				if( ((std::get<Is>(ptrs) == nullptr) || ...) ) { values = {}; return; }
+				(std::memcpy( &std::get<Is>(values), std::get<Is>(ptrs), sizeof(std::get<Is>(values)) ), ...);
+			};
+			fun(std::index_sequence_for<Ts...>{});
+			return !m_seqLock.ReadRetry(seq);
+		}
+
+		/// @brief Read a component value optimistically, retry until the read is consistent.
+		/// @tparam U The type of the component, must be trivially copyable.
+		/// @param archIndex The index of the entity in the archetype.
+		/// @return The component value.
+		template<typename U>
+		[[nodiscard]] auto ReadOptimistic(size_t archIndex) -> component_value_t<U> {
+			std::tuple<component_value_t<U>> value;
+			while( !TryRead<U>(archIndex, m_seqLock.ReadBegin(), value) ) {}
+			return std::get<0>(value);
 		}
 
 		/// @brief Put component values to an entity.
@@ -95,12 +147,16 @@ namespace vecs {
 
 		/// @brief Move components from another archetype to this one. In the other archetype,
 		/// the last entity is moved to the erased one. This might result in a reindexing of the moved entity in the slot map.
+		/// Components of the types Ts are constructed from the given values instead of being copied or default constructed.
 		/// @param other The other archetype.
 		/// @param other_index The index of the entity in the other archetype.
+		/// @param vs Values of components of this archetype.
 		/// @return A pair of the index of the new entity in this archetype and the handle of the moved entity.
-		auto Move( Archetype& other, size_t other_index ) -> std::pair<size_t, Handle> {			
+		template<typename... Ts>
+		auto Move( Archetype& other, size_t other_index, Ts&&... vs ) -> std::pair<size_t, Handle> {			
 			for( auto& ti : m_types ) { //go through all maps
 				if( m_maps.contains(ti) ) {
+					if( ((ti == Type<std::decay_t<Ts>>() && (AddValue(std::forward<Ts>(vs)), true)) || ...) ) { continue; } //new value
 					if( other.m_maps.contains(ti) ) {
 						m_maps[ti]->copy(other.Map(ti), other_index); //insert the new value
 					} else {
@@ -108,7 +164,7 @@ namespace vecs {
 					}
 				}
 			}
-			++m_changeCounter;
+			m_changeCounter.Add(1);
 			return { m_maps[Type<Handle>()]->size() - 1, other.Erase2(other_index) }; 
 		}
 
@@ -125,6 +181,96 @@ namespace vecs {
 			}
 		}
 
+		/// @brief Create a snapshot of the archetype. All component maps share their segments copy-on-write,
+		/// so the snapshot costs O(number of segments) and stays unchanged when the archetype is changed later.
+		/// @return The snapshot.
+		auto Snapshot() -> std::unique_ptr<Archetype> {
+			auto arch = std::unique_ptr<Archetype>(new Archetype(0));
+			arch->m_types = m_types;
+			arch->m_gaps = m_gaps;
+			for( auto& map : m_maps ) { arch->m_maps[map.first] = map.second->snapshot(); }
+			return arch;
+		}
+
+		/// @brief Restore the component maps from a snapshot of this archetype. The segments are shared copy-on-write
+		/// with the snapshot, so the snapshot can be restored again.
+		/// @param snapshot The snapshot to restore.
+		void Restore(Archetype& snapshot) {
+			assert( m_types == snapshot.m_types );
+			for( auto& map : m_maps ) { map.second = snapshot.Map(map.first)->snapshot(); }
+			m_gaps = snapshot.m_gaps;
+			m_gapsSorted = false;
+			m_changeCounter.Add(1);
+		}
+
+		/// @brief Compute a deterministic hash of the archetype. Columns are hashed in the order of their type hashes,
+		/// the handle column includes the slot versions of the entities. Gaps are skipped, and the rows are hashed in
+		/// the order that filling all gaps would leave, see FillGap(), so the hash does not depend on compaction.
+		/// @param seed The seed.
+		/// @return The hash.
+		auto Checksum(size_t seed) -> size_t {
+			std::vector<size_t> rows;
+			if( !m_gaps.empty() ) {
+				if( !m_gapsSorted ) { std::ranges::sort(m_gaps); m_gapsSorted = true; }
+				rows.resize(Number());
+				for( size_t i = 0; i < rows.size(); ++i ) { rows[i] = i; }
+				for( auto gap = m_gaps.rbegin(); gap != m_gaps.rend(); ++gap ) { rows[*gap] = rows.back(); rows.pop_back(); }
+			}
+			for( auto ti : m_types ) { //sorted set
+				seed = HashCombine(seed, ti);
+				if( auto it = m_maps.find(ti); it != m_maps.end() ) { 
+					seed = m_gaps.empty() ? it->second->checksum(seed) : it->second->checksum(seed, rows); 
+				}
+			}
+			return seed;
+		}
+
+		/// @brief Preallocate all component maps for a maximum number of entities, see Registry::Registry().
+		/// @param capacity The maximum number of entities.
+		void Reserve(size_t capacity) {
+			m_capacity = capacity;
+			for( auto& map : m_maps ) { map.second->reserve(capacity); }
+		}
+
+		/// @brief Test if the archetype has reached its reserved capacity.
+		/// @return true if no more entities can be added without allocating.
+		bool Full() {
+			return m_capacity > 0 && Number() >= m_capacity;
+		}
+
+		/// @brief Test if the archetype has gaps, i.e. rows of erased entities that have not been compacted yet.
+		/// Gaps have an invalid handle and are skipped by iterators.
+		/// @return true if there are gaps.
+		bool HasGaps() {
+			return !m_gaps.empty();
+		}
+
+		/// @brief Get the number of gaps.
+		/// @return The number of gaps.
+		size_t Gaps() {
+			return m_gaps.size();
+		}
+
+		/// @brief Defer compaction. Then erasing an entity only leaves a gap, see Registry::SetDeferredCompaction().
+		/// @param defer If true, erasures leave gaps.
+		void SetDeferCompaction(bool defer) {
+			m_deferCompaction = defer;
+		}
+
+		/// @brief Fill the gap with the largest index by moving the last row into it. Filling gaps from the largest 
+		/// index downwards ensures that the last row is never a gap itself.
+		/// @return The index of the filled gap, and the handle of the moved entity or an invalid handle if none was moved.
+		auto FillGap() -> std::pair<size_t, Handle> {
+			assert( !m_gaps.empty() );
+			if( !m_gapsSorted ) { std::ranges::sort(m_gaps); m_gapsSorted = true; }
+			size_t gap = m_gaps.back();
+			m_gaps.pop_back();
+			size_t last{gap};
+			m_changeCounter.Add(1);
+			for( auto& it : m_maps ) { last = it.second->erase(gap); }
+			return { gap, gap < last ? Read<Handle>(gap) : Handle{} };
+		}
+
 		/// @brief Get the number of entites in this archetype.
 		/// @return The number of entities.
 		size_t Size() {
@@ -138,12 +284,27 @@ namespace vecs {
 			return m_maps[Type<Handle>()]->size();
 		}
 
+		/// @brief Free segments retired for optimistic readers, see Vector<T>::reclaim().
+		void Reclaim() {
+			for( auto& map : m_maps ) {
+				map.second->reclaim();
+			}
+		}
+
+		/// @brief Swap current and previous buffers of all double buffered components.
+		void SwapBuffers() {
+			for( auto& map : m_maps ) {
+				map.second->swap_buffers();
+			}
+		}
+
 		/// @brief Clear the archetype.
 		void Clear() {
 			for( auto& map : m_maps ) {
 				map.second->clear();
 			}
-			++m_changeCounter;
+			m_gaps.clear();
+			m_changeCounter.Add(1);
 		}
 
 		/// @brief Print the archetype.
@@ -176,7 +337,7 @@ namespace vecs {
 		/// @brief Get the change counter of the archetype. It is increased when a change occurs
 		/// that might invalidate a Ref object, e.g. when an entity is moved to another archetype, or erased.
 		auto GetChangeCounter() -> size_t {
-			return m_changeCounter;
+			return m_changeCounter.Get();
 		}
 
 		/// @brief Get the mutex of the archetype.
@@ -185,16 +346,31 @@ namespace vecs {
 			return m_mutex;
 		}
 
+		/// @brief Get the sequence lock of the archetype. Writers of component values mark their writes with it, 
+		/// so that readers of read mostly components can read without locking.
+		/// @return Reference to the sequence lock.
+		[[nodiscard]] auto GetSeqLock() -> SeqLock& {
+			return m_seqLock;
+		}
+
 		void AddType(size_t ti) {
 			assert( !m_types.contains(ti) );
 			m_types.insert(ti);	//add the type to the list
 		};
 
+		/// @brief Add a component with a column that was created at runtime, see RawVector.
+		/// @param ti The id of the component.
+		/// @param map The component map.
+		void AddColumn(size_t ti, std::unique_ptr<VectorBase>&& map) {
+			AddType(ti);
+			m_maps[ti] = std::move(map);
+		}
+
 		/// @brief Add a new component to the archetype.
 		/// @tparam T The type of the component.
 		template<typename U>
 		void AddComponent() {
-			using T = std::decay_t<U>; //remove pointer or reference
+			using T = column_t<U>; //remove pointer or reference, Cur<T> and Prev<T> are stored as DoubleBuffered<T>
 			size_t ti = Type<T>();
 			assert( !m_types.contains(ti) );
 			m_types.insert(ti);	//add the type to the list
@@ -210,19 +386,32 @@ namespace vecs {
 			return m_maps[Type<T>()]->push_back(std::forward<U>(v));	//insert the component value
 		};
 
+		/// @brief Add a new component value to the archetype, constructed in place from its constructor arguments.
+		/// @param v The constructor arguments.
+		/// @return The index of the component value.
+		template<typename T, typename Tuple>
+		auto AddValue( InPlace<T, Tuple>&& v ) -> size_t {
+			return std::apply( [&](auto&&... args) { 
+				return m_maps[Type<T>()]->template emplace_back<T>(std::forward<decltype(args)>(args)...); 
+			}, std::move(v.m_args) );
+		};
+
 		auto AddEmptyValue( size_t ti ) -> size_t {
 			return m_maps[ti]->push_back();	//insert the component value
 		};
 
-		/// @brief Get the map of the components.
+		/// @brief Get the map of the components. For Cur<T> and Prev<T> this is the respective buffer of the double buffered component.
 		/// @tparam T The type of the component.
 		/// @return Pointer to the component map.
 		template<typename U>
-		auto Map() -> Vector<std::decay_t<U>>* {
+		auto Map() -> Vector<component_value_t<U>>* {
 			using T = std::decay_t<U>;
 			auto it = m_maps.find(Type<T>());
 			assert(it != m_maps.end());
-			return static_cast<Vector<T>*>(it->second.get());
+			auto map = static_cast<Vector<column_t<T>>*>(it->second.get());
+			if constexpr (std::is_same_v<T, Cur<component_value_t<T>>>) { return &map->Current(); }
+			else if constexpr (std::is_same_v<T, Prev<component_value_t<T>>>) { return &map->Previous(); }
+			else return map;
 		}
 
 		/// @brief Get the data of the components.
@@ -236,15 +425,21 @@ namespace vecs {
 
 	private:
 
+		/// @brief Constructor for snapshots, creates an archetype without any component map.
+		Archetype(int) {}
+
 		/// @brief Erase an entity. To ensure thet consistency of the entity indices, the last entity is moved to the erased one.
 		/// This might result in a reindexing of the moved entity in the slot map. Thus we need a ref to the slot map
+		/// If the erasure is deferred, the row becomes a gap instead. This is the case if the entity was already visited 
+		/// by an iterator, if compaction is deferred, or if there are gaps already, since the last row might be one.
 		/// @param index The index of the entity in the archetype.
 		/// @return The handle of the moved last entity.
 		auto Erase2(size_t index) -> Handle {
 			size_t last{index};
-			++m_changeCounter;
-			if( m_iteratingArchetype == this && index <= m_iteratingIndex ) {  //delayed erasure
+			m_changeCounter.Add(1);
+			if( m_deferCompaction || !m_gaps.empty() || (m_iteratingArchetype == this && index <= m_iteratingIndex) ) {  //delayed erasure
 				m_gaps.push_back(index); 
+				m_gapsSorted = false;
 				(*Map<Handle>())[index] = Handle{}; //invalidate the handle
 				return Handle{}; 
 			}
@@ -253,10 +448,20 @@ namespace vecs {
 		}
 
 		using Map_t = std::unordered_map<size_t, std::unique_ptr<VectorBase>>;
-		Mutex_t 			m_mutex; //mutex for thread safety
-		Size_t 				m_changeCounter{0}; //changes invalidate references
-		std::set<size_t> 	m_types; //types of components
+		#ifdef REGISTRYTYPE_SEQUENTIAL
+			using ChangeCounter_t = StripedCounter<1, int64_t>;
+		#else
+			using ChangeCounter_t = StripedCounter<16, std::atomic<int64_t>>;
+		#endif
+		alignas(CACHE_LINE_SIZE) Mutex_t m_mutex; //mutex for thread safety, on its own cache line
+		ChangeCounter_t		m_changeCounter; //changes invalidate references, written by every insert, per-thread accumulators
+		alignas(CACHE_LINE_SIZE) SeqLock m_seqLock; //marks writes for optimistic readers
+		alignas(CACHE_LINE_SIZE) std::set<size_t> m_types; //types of components, read mostly
 		Map_t 				m_maps; //map from type index to component data
+		size_t 				m_capacity{0}; //maximum number of entities, 0 if unlimited
+		std::vector<size_t> m_gaps; //gaps from erasures that must be filled, see FillGap()
+		bool 				m_gapsSorted{true}; //true if m_gaps is sorted
+		bool 				m_deferCompaction{false}; //if true, erasures always leave gaps
 
 	public:
 		//Parallelization strategy (not yet implemented):
@@ -269,7 +474,6 @@ namespace vecs {
 		//    Also the archetype stays in write lock until the end of the iteration.
 		inline static thread_local Archetype* m_iteratingArchetype{nullptr}; //for iterating over archetypes
 		inline static thread_local size_t m_iteratingIndex{std::numeric_limits<size_t>::max()}; //current iterator index
-		inline static thread_local std::vector<size_t> m_gaps{}; //gaps from previous erasures that must be filled
 	}; //end of Archetype
 
 } //namespace vecs2
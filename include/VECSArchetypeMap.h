@@ -0,0 +1,116 @@
+#pragma once
+
+namespace vecs {
+
+	//----------------------------------------------------------------------------------------------
+	//Archetype Map
+
+	/// @brief A flat open-addressing hash table mapping the full sorted type signature of an archetype to the archetype.
+	/// Archetypes are stored densely in insertion order, the bucket array only holds the cached hash and the index
+	/// of the entry. A lookup compares cached hashes first and then the full signature, so two different type sets
+	/// whose hashes collide always end up in different archetypes.
+	class ArchetypeMap {
+
+	public:
+
+		/// @brief An entry of the map, holding the cached hash, the sorted signature and the archetype.
+		struct Entry {
+			size_t 						m_hash;		//hash of the signature
+			std::vector<size_t> 		m_types;	//sorted type hashes of the archetype
+			std::unique_ptr<Archetype> 	m_arch;		//the archetype
+		};
+
+	private:
+
+		/// @brief A bucket of the table. Empty buckets have an entry index of EMPTY.
+		struct Bucket {
+			size_t m_hash{0};		//cached hash of the signature
+			size_t m_entry{EMPTY};	//index of the entry in the entry vector
+		};
+
+		static const size_t EMPTY = std::numeric_limits<size_t>::max();
+
+	public:
+
+		/// @brief Constructor, creates the map.
+		/// @param bits The initial number of buckets is 2^bits.
+		ArchetypeMap(size_t bits = 6) : m_buckets(1ull << bits), m_mask{(1ull << bits) - 1} {}
+
+		/// @brief Find an archetype.
+		/// @param hash The hash of the signature.
+		/// @param types The sorted signature.
+		/// @return Pointer to the archetype, or nullptr if there is no archetype with this signature.
+		auto Find(size_t hash, std::span<const size_t> types) -> Archetype* {
+			for( size_t i = Mix(hash) & m_mask; m_buckets[i].m_entry != EMPTY; i = (i + 1) & m_mask ) {
+				auto& bucket = m_buckets[i];
+				if( bucket.m_hash == hash && std::ranges::equal(m_entries[bucket.m_entry].m_types, types) ) {
+					return m_entries[bucket.m_entry].m_arch.get();
+				}
+			}
+			return nullptr;
+		}
+
+		/// @brief Insert a new archetype. The signature must not be in the map yet.
+		/// @param hash The hash of the signature.
+		/// @param types The sorted signature.
+		/// @param arch The archetype.
+		/// @return Pointer to the archetype.
+		auto Insert(size_t hash, std::vector<size_t>&& types, std::unique_ptr<Archetype>&& arch) -> Archetype* {
+			assert( Find(hash, types) == nullptr );
+			if( 4 * (m_entries.size() + 1) > 3 * m_buckets.size() ) { Rehash(2 * m_buckets.size()); }
+			m_entries.push_back( Entry{ hash, std::move(types), std::move(arch) } );
+			Place(hash, m_entries.size() - 1);
+			return m_entries.back().m_arch.get();
+		}
+
+		/// @brief Allocate buckets and entries for at least n archetypes, so inserting them does not rehash.
+		/// @param n The number of archetypes.
+		void reserve(size_t n) {
+			m_entries.reserve(n);
+			size_t size = m_buckets.size();
+			while( 3 * size < 4 * n ) { size *= 2; }
+			if( size > m_buckets.size() ) { Rehash(size); }
+		}
+
+		/// @brief Get the number of archetypes.
+		/// @return The number of archetypes.
+		auto size() const -> size_t { return m_entries.size(); }
+
+		auto begin() { return m_entries.begin(); }
+		auto end() { return m_entries.end(); }
+
+	private:
+
+		/// @brief Spread the bits of the hash, since the low bits select the bucket.
+		/// @param hash The hash of the signature.
+		/// @return The mixed hash.
+		static size_t Mix(size_t hash) {
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+		/// @brief Put an entry into the first free bucket of its probe sequence.
+		/// @param hash The hash of the signature.
+		/// @param entry The index of the entry.
+		void Place(size_t hash, size_t entry) {
+			size_t i = Mix(hash) & m_mask;
+			while( m_buckets[i].m_entry != EMPTY ) { i = (i + 1) & m_mask; }
+			m_buckets[i] = { hash, entry };
+		}
+
+		/// @brief Resize the bucket array and reinsert all entries, using the cached hashes.
+		/// @param size The new number of buckets, a power of 2.
+		void Rehash(size_t size) {
+			m_buckets.assign(size, Bucket{});
+			m_mask = size - 1;
+			for( size_t i = 0; i < m_entries.size(); ++i ) { Place(m_entries[i].m_hash, i); }
+		}
+
+		std::vector<Bucket> m_buckets;	///< Open addressing table with linear probing.
+		size_t 				m_mask;		///< Number of buckets minus one.
+		std::vector<Entry> 	m_entries;	///< Archetypes in insertion order.
+	}; //end of ArchetypeMap
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+namespace vecs {
+
+	//----------------------------------------------------------------------------------------------
+	//Event channels
+
+	/// @brief Base class of all event channels, so the registry can flush them without knowing the event types.
+	class EventChannelBase {
+
+	public:
+		EventChannelBase() = default;
+		virtual ~EventChannelBase() = default;
+		virtual void Flush() = 0;
+		virtual void Clear() = 0;
+	};
+
+	/// @brief A channel for events of type E, sent from one or more systems to others without creating entities.
+	/// Each thread appends to the buffer of its thread index modulo N, see ThreadIndex(), which sits on its own cache 
+	/// line. In parallel mode a buffer is guarded by a spinlock, which is only contended if two emitting threads 
+	/// share a buffer. Flush() moves all buffered events into one contiguous array, which consumers read with Read(). 
+	/// Buffers keep their memory, so a steady stream of events does not allocate.
+	/// @tparam E The type of the events.
+	/// @tparam N The number of per-thread buffers, a power of 2.
+	template<typename E, size_t N = 64>
+		requires (N > 0 && (N & (N - 1)) == 0)
+	class EventChannel : public EventChannelBase {
+
+		/// @brief The events of one or more threads.
+		struct Buffer {
+			SpinMutex m_mutex;			//guards the buffer in parallel mode
+			std::vector<E> m_events;	//emitted events
+		};
+
+	public:
+		EventChannel() = default;
+
+		/// @brief Send an event. Can be called by many threads at the same time, but not during Flush().
+		/// @param event The event.
+		template<typename U>
+		void Emit(U&& event) {
+			auto& buffer = m_buffers[ThreadIndex() & (N - 1)].m_value;
+			LockGuard<LOCKGUARDTYPE, SpinMutex> lock(&buffer.m_mutex);
+			buffer.m_events.push_back(std::forward<U>(event));
+		}
+
+		/// @brief Make all events emitted since the last flush readable, replacing the events read so far. Events of
+		/// the same thread keep their order. Call this at the end of a frame, when no thread is emitting.
+		void Flush() override {
+			m_events.clear();
+			for( auto& buffer : m_buffers ) { 
+				auto& events = buffer.m_value.m_events;
+				m_events.insert(m_events.end(), std::make_move_iterator(events.begin()), std::make_move_iterator(events.end()));
+				events.clear();
+			}
+		}
+
+		/// @brief Remove all readable events. The buffered events are kept.
+		void Clear() override { m_events.clear(); }
+
+		/// @brief Get the events made readable by the last Flush().
+		/// @return The events, contiguous in memory.
+		auto Read() const -> std::span<const E> { return m_events; }
+
+	private:
+		std::array<CacheLinePadded<Buffer>, N> m_buffers; ///< Buffers by thread index.
+		std::vector<E> m_events; ///< Readable events.
+	}; //end of EventChannel
+
+} //namespace vecs
@@ -46,6 +46,11 @@ namespace vecs {
 	
 }
 
+template<>
+struct std::hash<vecs::Handle> {
+	size_t operator()(const vecs::Handle& handle) const { return std::hash<size_t>{}(handle.GetValue()); }
+};
+
 inline std::ostream& operator<<(std::ostream& os, const vecs::Handle& handle) {
 	return os << "{" <<  handle.GetIndex() << ", " << handle.GetVersion() << ", " << handle.GetStorageIndex() << "}"; 
 }
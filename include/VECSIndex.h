@@ -0,0 +1,723 @@
+#pragma once
+
+namespace vecs {
+
+	//----------------------------------------------------------------------------------------------
+	//Index base
+
+	/// @brief Base class of all indexes. An index observes the entities of the archetypes it matches.
+	/// The registry calls Add() when an entity enters a matching archetype or after one of the components the index
+	/// depends on was written, and Remove() when the entity leaves the archetype or before such a component is written.
+	/// In both cases the entity is at the given index of the archetype and holds its current values. Entities are
+	/// identified by their handles, so moving rows inside an archetype does not affect an index.
+	class IndexBase {
+
+	public:
+		IndexBase() = default;
+		virtual ~IndexBase() = default;
+
+		/// @brief Test if entities of an archetype are indexed.
+		/// @param arch The archetype.
+		/// @return true if the entities of the archetype are indexed.
+		virtual bool Matches(Archetype* arch) = 0;
+
+		/// @brief Test if writing a component changes the index.
+		/// @param ti Type hash of the component.
+		/// @return true if the index depends on the component.
+		virtual bool DependsOn(size_t ti) = 0;
+
+		/// @brief Add an entity to the index.
+		/// @param handle The handle of the entity.
+		/// @param arch The archetype of the entity.
+		/// @param index The index of the entity in the archetype.
+		virtual void Add(Handle handle, Archetype* arch, size_t index) = 0;
+
+		/// @brief Remove an entity from the index.
+		/// @param handle The handle of the entity.
+		/// @param arch The archetype of the entity.
+		/// @param index The index of the entity in the archetype.
+		virtual void Remove(Handle handle, Archetype* arch, size_t index) = 0;
+
+		/// @brief Remove all entities from the index.
+		virtual void Clear() = 0;
+
+		/// @brief Get the mutex of the index.
+		/// @return Reference to the mutex.
+		[[nodiscard]] auto GetMutex() -> Mutex_t& { return m_mutex; }
+
+	protected:
+		Mutex_t m_mutex; ///< Protects the index in parallel mode.
+	}; //end of IndexBase
+
+
+	//----------------------------------------------------------------------------------------------
+	//Hash index
+
+	/// @brief An unordered index mapping values of component T to handles of entities. A unique index holds at most
+	/// one entity per value, a multi index holds any number. T must be hashable with std::hash.
+	template<typename T>
+	class HashIndex : public IndexBase {
+
+	public:
+		using value_t = T;
+
+		/// @brief Constructor.
+		/// @param unique If true, at most one entity can have a value.
+		HashIndex(bool unique) : m_unique{unique} {}
+
+		bool Matches(Archetype* arch) override { return arch->Has(Type<T>()); }
+		bool DependsOn(size_t ti) override { return ti == Type<T>(); }
+
+		void Add(Handle handle, Archetype* arch, size_t index) override {
+			auto& value = arch->template Read<T>(index);
+			if( m_unique ) {
+				auto it = m_map.find(value);
+				assert( it == m_map.end() ); //value is not unique
+				if( it != m_map.end() ) { it->second = handle; return; }
+			}
+			m_map.emplace(value, handle);
+		}
+
+		void Remove(Handle handle, Archetype* arch, size_t index) override {
+			auto [begin, end] = m_map.equal_range( arch->template Read<T>(index) );
+			for( auto it = begin; it != end; ++it ) {
+				if( it->second.GetValue() == handle.GetValue() ) { m_map.erase(it); return; }
+			}
+		}
+
+		void Clear() override { m_map.clear(); }
+
+		/// @brief Find an entity with a value.
+		/// @param value The value.
+		/// @return The handle of an entity with this value, or an invalid handle if there is none.
+		auto Find(const T& value) -> Handle {
+			auto it = m_map.find(value);
+			return it != m_map.end() ? it->second : Handle{};
+		}
+
+		/// @brief Find all entities with a value.
+		/// @param value The value.
+		/// @return The handles of all entities with this value.
+		auto FindAll(const T& value) -> std::vector<Handle> {
+			std::vector<Handle> handles;
+			auto [begin, end] = m_map.equal_range(value);
+			for( auto it = begin; it != end; ++it ) { handles.push_back(it->second); }
+			return handles;
+		}
+
+		/// @brief Get the number of indexed entities.
+		/// @return The number of entities.
+		auto Size() -> size_t { return m_map.size(); }
+
+		/// @brief Test if the index is unique.
+		/// @return true if the index is unique.
+		bool IsUnique() { return m_unique; }
+
+	private:
+		bool m_unique; ///< If true, at most one entity per value.
+		std::unordered_multimap<T, Handle> m_map; ///< Map from values to handles.
+	}; //end of HashIndex
+
+
+	//----------------------------------------------------------------------------------------------
+	//Ordered index
+
+	/// @brief An ordered index over the values of component T, implemented as a B+tree. Leaves hold up to N values 
+	/// and handles in two contiguous arrays and are linked, so a range query descends the tree once and then 
+	/// walks the leaves sequentially. Equal values are ordered by handle. Erasing never merges leaves, empty nodes 
+	/// are unlinked, so all leaves stay on the same depth. T must be ordered with operator<.
+	/// @tparam T The type of the component.
+	/// @tparam N The maximum number of entries of a node.
+	template<typename T, size_t N = 64>
+	class OrderedIndex : public IndexBase {
+
+		static_assert(N >= 4);
+
+		using key_t = std::pair<T, size_t>; //value and handle value
+
+		/// @brief Base of inner nodes and leaves.
+		struct Node {
+			Node(bool leaf) : m_leaf{leaf} {}
+			virtual ~Node() = default;
+			bool m_leaf;		//true for a leaf
+			size_t m_size{0};	//number of entries of a leaf, or number of children of an inner node
+		};
+
+		/// @brief A leaf, one slot larger than N so that an entry can be inserted before splitting.
+		struct Leaf : Node {
+			Leaf() : Node{true} {}
+			std::array<T, N + 1> m_values;			//sorted values
+			std::array<Handle, N + 1> m_handles;	//handles of the values
+			Leaf* m_prev{nullptr};					//previous leaf in order
+			Leaf* m_next{nullptr};					//next leaf in order
+		};
+
+		/// @brief An inner node. Separator i is the smallest key of child i+1.
+		struct Inner : Node {
+			Inner() : Node{false} {}
+			std::array<key_t, N + 1> m_keys;						//separators
+			std::array<std::unique_ptr<Node>, N + 2> m_children;	//children
+		};
+
+		/// @brief Result of inserting into a node that had to be split.
+		struct Split {
+			key_t m_key;					//smallest key of the new right node
+			std::unique_ptr<Node> m_right;	//the new right node
+		};
+
+	public:
+		using value_t = T;
+
+		OrderedIndex() = default;
+
+		bool Matches(Archetype* arch) override { return arch->Has(Type<T>()); }
+		bool DependsOn(size_t ti) override { return ti == Type<T>(); }
+
+		void Add(Handle handle, Archetype* arch, size_t index) override {
+			auto split = Insert(m_root.get(), arch->template Read<T>(index), handle);
+			if( split ) {
+				auto root = std::make_unique<Inner>();
+				root->m_keys[0] = std::move(split->m_key);
+				root->m_children[0] = std::move(m_root);
+				root->m_children[1] = std::move(split->m_right);
+				root->m_size = 2;
+				m_root = std::move(root);
+			}
+			++m_size;
+		}
+
+		void Remove(Handle handle, Archetype* arch, size_t index) override {
+			key_t key{ arch->template Read<T>(index), handle.GetValue() };
+			if( !Erase(m_root.get(), key) ) { return; }
+			--m_size;
+			while( !m_root->m_leaf && m_root->m_size <= 1 ) { //shrink the tree
+				auto inner = static_cast<Inner*>(m_root.get());
+				if( inner->m_size == 0 ) { m_root = std::make_unique<Leaf>(); break; }
+				m_root = std::move(inner->m_children[0]);
+			}
+		}
+
+		void Clear() override { m_root = std::make_unique<Leaf>(); m_size = 0; }
+
+		/// @brief Call a function for each run of consecutive entries in [lo, hi). Each run lies in one leaf, 
+		/// so the values and handles are contiguous in memory.
+		/// @param lo Smallest value, or std::nullopt for no lower bound.
+		/// @param hi Value after the largest value, or std::nullopt for no upper bound.
+		/// @param fun Function called with a std::span<const T> of values and a std::span<const Handle> of their handles.
+		void ForEachChunk(const std::optional<T>& lo, const std::optional<T>& hi, auto&& fun) {
+			auto [leaf, pos] = LowerBound(lo);
+			for( ; leaf != nullptr; leaf = leaf->m_next, pos = 0 ) {
+				size_t end = leaf->m_size;
+				if( hi ) { end = std::lower_bound(leaf->m_values.begin() + pos, leaf->m_values.begin() + end, *hi) - leaf->m_values.begin(); }
+				if( end > pos ) {
+					fun( std::span<const T>{ leaf->m_values.data() + pos, end - pos }, 
+						 std::span<const Handle>{ leaf->m_handles.data() + pos, end - pos } );
+				}
+				if( end < leaf->m_size ) { return; }
+			}
+		}
+
+		/// @brief Find all entities with a value in [lo, hi), ordered by value.
+		/// @param lo Smallest value, or std::nullopt for no lower bound.
+		/// @param hi Value after the largest value, or std::nullopt for no upper bound.
+		/// @return The handles of the entities.
+		auto Range(const std::optional<T>& lo, const std::optional<T>& hi) -> std::vector<Handle> {
+			std::vector<Handle> handles;
+			ForEachChunk(lo, hi, [&](auto, auto chunk) { handles.insert(handles.end(), chunk.begin(), chunk.end()); });
+			return handles;
+		}
+
+		/// @brief Get the number of indexed entities.
+		/// @return The number of entities.
+		auto Size() -> size_t { return m_size; }
+
+	private:
+
+		/// @brief Compare entries, by value first and by handle value second.
+		static bool Less(const T& a, size_t ah, const T& b, size_t bh) { return a < b || (!(b < a) && ah < bh); }
+		static bool Less(const key_t& a, const key_t& b) { return Less(a.first, a.second, b.first, b.second); }
+
+		/// @brief Get the key of an entry of a leaf.
+		static auto Key(const Leaf* leaf, size_t i) -> key_t { return { leaf->m_values[i], leaf->m_handles[i].GetValue() }; }
+
+		/// @brief Get the position of the first entry of a leaf that is not less than a key.
+		static auto Position(const Leaf* leaf, const key_t& key) -> size_t {
+			size_t i = 0;
+			for( size_t count = leaf->m_size; count > 0; ) { //binary search
+				size_t half = count / 2;
+				if( Less(leaf->m_values[i + half], leaf->m_handles[i + half].GetValue(), key.first, key.second) ) { i += half + 1; count -= half + 1; }
+				else { count = half; }
+			}
+			return i;
+		}
+
+		/// @brief Get the child of an inner node whose range contains a key.
+		static auto Child(const Inner* inner, const key_t& key) -> size_t {
+			return std::upper_bound(inner->m_keys.begin(), inner->m_keys.begin() + inner->m_size - 1, key, 
+				[](const key_t& a, const key_t& b) { return Less(a, b); }) - inner->m_keys.begin();
+		}
+
+		/// @brief Insert an entry into a subtree.
+		/// @return The split of the node if it overflowed.
+		auto Insert(Node* node, const T& value, Handle handle) -> std::optional<Split> {
+			key_t key{ value, handle.GetValue() };
+			if( node->m_leaf ) {
+				auto leaf = static_cast<Leaf*>(node);
+				size_t pos = Position(leaf, key);
+				std::move_backward(leaf->m_values.begin() + pos, leaf->m_values.begin() + leaf->m_size, leaf->m_values.begin() + leaf->m_size + 1);
+				std::move_backward(leaf->m_handles.begin() + pos, leaf->m_handles.begin() + leaf->m_size, leaf->m_handles.begin() + leaf->m_size + 1);
+				leaf->m_values[pos] = value;
+				leaf->m_handles[pos] = handle;
+				if( ++leaf->m_size <= N ) { return std::nullopt; }
+
+				auto right = std::make_unique<Leaf>(); //split the leaf
+				size_t half = leaf->m_size / 2;
+				std::move(leaf->m_values.begin() + half, leaf->m_values.begin() + leaf->m_size, right->m_values.begin());
+				std::move(leaf->m_handles.begin() + half, leaf->m_handles.begin() + leaf->m_size, right->m_handles.begin());
+				right->m_size = leaf->m_size - half;
+				leaf->m_size = half;
+				right->m_next = leaf->m_next;
+				right->m_prev = leaf;
+				if( leaf->m_next ) { leaf->m_next->m_prev = right.get(); }
+				leaf->m_next = right.get();
+				return Split{ Key(right.get(), 0), std::move(right) };
+			}
+
+			auto inner = static_cast<Inner*>(node);
+			size_t child = Child(inner, key);
+			auto split = Insert(inner->m_children[child].get(), value, handle);
+			if( !split ) { return std::nullopt; }
+			std::move_backward(inner->m_keys.begin() + child, inner->m_keys.begin() + inner->m_size - 1, inner->m_keys.begin() + inner->m_size);
+			std::move_backward(inner->m_children.begin() + child + 1, inner->m_children.begin() + inner->m_size, inner->m_children.begin() + inner->m_size + 1);
+			inner->m_keys[child] = std::move(split->m_key);
+			inner->m_children[child + 1] = std::move(split->m_right);
+			if( ++inner->m_size <= N + 1 ) { return std::nullopt; }
+
+			auto right = std::make_unique<Inner>(); //split the inner node, the middle separator moves up
+			size_t half = inner->m_size / 2;
+			std::move(inner->m_keys.begin() + half, inner->m_keys.begin() + inner->m_size - 1, right->m_keys.begin());
+			std::move(inner->m_children.begin() + half, inner->m_children.begin() + inner->m_size, right->m_children.begin());
+			right->m_size = inner->m_size - half;
+			inner->m_size = half;
+			return Split{ std::move(inner->m_keys[half - 1]), std::move(right) };
+		}
+
+		/// @brief Erase an entry from a subtree. Empty leaves are unlinked, and empty nodes are removed from their parents.
+		/// @return true if the entry was found.
+		bool Erase(Node* node, const key_t& key) {
+			if( node->m_leaf ) {
+				auto leaf = static_cast<Leaf*>(node);
+				size_t pos = Position(leaf, key);
+				if( pos == leaf->m_size || Less(key.first, key.second, leaf->m_values[pos], leaf->m_handles[pos].GetValue()) ) { return false; }
+				std::move(leaf->m_values.begin() + pos + 1, leaf->m_values.begin() + leaf->m_size, leaf->m_values.begin() + pos);
+				std::move(leaf->m_handles.begin() + pos + 1, leaf->m_handles.begin() + leaf->m_size, leaf->m_handles.begin() + pos);
+				--leaf->m_size;
+				if( leaf->m_size == 0 && leaf != m_root.get() ) { //unlink the empty leaf, the parent removes it
+					if( leaf->m_prev ) { leaf->m_prev->m_next = leaf->m_next; }
+					if( leaf->m_next ) { leaf->m_next->m_prev = leaf->m_prev; }
+				}
+				return true;
+			}
+
+			auto inner = static_cast<Inner*>(node);
+			size_t child = Child(inner, key);
+			if( !Erase(inner->m_children[child].get(), key) ) { return false; }
+			if( inner->m_children[child]->m_size > 0 ) { return true; }
+			size_t sep = child > 0 ? child - 1 : 0; //remove the empty child and one of its separators
+			if( inner->m_size > 1 ) { std::move(inner->m_keys.begin() + sep + 1, inner->m_keys.begin() + inner->m_size - 1, inner->m_keys.begin() + sep); }
+			std::move(inner->m_children.begin() + child + 1, inner->m_children.begin() + inner->m_size, inner->m_children.begin() + child);
+			inner->m_children[--inner->m_size].reset();
+			return true;
+		}
+
+		/// @brief Find the first entry not less than a value.
+		/// @param lo The value, or std::nullopt for the first entry.
+		/// @return The leaf and the position in the leaf.
+		auto LowerBound(const std::optional<T>& lo) -> std::pair<Leaf*, size_t> {
+			Node* node = m_root.get();
+			while( !node->m_leaf ) {
+				auto inner = static_cast<Inner*>(node);
+				node = inner->m_children[lo ? Child(inner, key_t{ *lo, 0 }) : 0].get();
+			}
+			auto leaf = static_cast<Leaf*>(node);
+			size_t pos = lo ? std::lower_bound(leaf->m_values.begin(), leaf->m_values.begin() + leaf->m_size, *lo) - leaf->m_values.begin() : 0;
+			return { leaf, pos };
+		}
+
+		std::unique_ptr<Node> m_root{std::make_unique<Leaf>()}; ///< Root of the tree.
+		size_t m_size{0}; ///< Number of entries.
+	}; //end of OrderedIndex
+
+
+	//----------------------------------------------------------------------------------------------
+	//Spatial index
+
+	/// @brief A uniform grid over the positions of entities, stored in component P. P must either have members x and y,
+	/// and optionally z, or be indexable like std::array<float, 2> or std::array<float, 3>. Cells are kept in a hash
+	/// map, so the grid is unbounded and only occupied cells use memory. Each cell stores the handles together with 
+	/// the positions, so queries do not touch the archetypes.
+	/// @tparam P The type of the position component.
+	template<typename P>
+	class SpatialIndex : public IndexBase {
+
+	public:
+		using value_t = P;
+		using point_t = std::array<float, 3>;
+
+		/// @brief An entity in a cell.
+		struct Entry {
+			Handle m_handle;	//the entity
+			point_t m_point;	//its position
+		};
+
+		/// @brief Constructor.
+		/// @param cellSize Edge length of the cubic cells. Queries are fastest if it is about the typical query radius.
+		SpatialIndex(float cellSize) : m_cellSize{cellSize} { assert(cellSize > 0.0f); }
+
+		bool Matches(Archetype* arch) override { return arch->Has(Type<P>()); }
+		bool DependsOn(size_t ti) override { return ti == Type<P>(); }
+
+		void Add(Handle handle, Archetype* arch, size_t index) override {
+			auto point = Point(arch->template Read<P>(index));
+			m_cells[Key(Cell(point))].push_back( { handle, point } );
+			++m_size;
+		}
+
+		void Remove(Handle handle, Archetype* arch, size_t index) override {
+			auto it = m_cells.find( Key(Cell(Point(arch->template Read<P>(index)))) );
+			if( it == m_cells.end() ) { return; }
+			auto& entries = it->second; //empty cells are kept, so entities moving back and forth do not allocate
+			for( size_t i = 0; i < entries.size(); ++i ) {
+				if( entries[i].m_handle.GetValue() == handle.GetValue() ) {
+					entries[i] = entries.back();
+					entries.pop_back();
+					--m_size;
+					return;
+				}
+			}
+		}
+
+		void Clear() override { m_cells.clear(); m_size = 0; }
+
+		/// @brief Call a function for all entities inside an axis aligned box, including its boundary.
+		/// @param lo The corner with the smallest coordinates.
+		/// @param hi The corner with the largest coordinates.
+		/// @param fun Function called with the handle and the position of each entity.
+		void ForEachInBox(const P& lo, const P& hi, auto&& fun) {
+			auto plo = Point(lo), phi = Point(hi);
+			auto inside = [&](const point_t& p) {
+				return plo[0] <= p[0] && p[0] <= phi[0] && plo[1] <= p[1] && p[1] <= phi[1] && plo[2] <= p[2] && p[2] <= phi[2];
+			};
+			ForEachCell(plo, phi, [&](const Entry& entry) { if( inside(entry.m_point) ) { fun(entry.m_handle, entry.m_point); } });
+		}
+
+		/// @brief Call a function for all entities inside a sphere, including its boundary.
+		/// @param center The center of the sphere.
+		/// @param radius The radius of the sphere.
+		/// @param fun Function called with the handle and the position of each entity.
+		void ForEachInRadius(const P& center, float radius, auto&& fun) {
+			auto c = Point(center);
+			point_t lo{ c[0] - radius, c[1] - radius, c[2] - radius }, hi{ c[0] + radius, c[1] + radius, c[2] + radius };
+			ForEachCell(lo, hi, [&](const Entry& entry) {
+				float dx = entry.m_point[0] - c[0], dy = entry.m_point[1] - c[1], dz = entry.m_point[2] - c[2];
+				if( dx * dx + dy * dy + dz * dz <= radius * radius ) { fun(entry.m_handle, entry.m_point); }
+			});
+		}
+
+		/// @brief Find all entities inside an axis aligned box, including its boundary.
+		/// @param lo The corner with the smallest coordinates.
+		/// @param hi The corner with the largest coordinates.
+		/// @return The handles of the entities.
+		auto InBox(const P& lo, const P& hi) -> std::vector<Handle> {
+			std::vector<Handle> handles;
+			ForEachInBox(lo, hi, [&](Handle handle, auto&) { handles.push_back(handle); });
+			return handles;
+		}
+
+		/// @brief Find all entities inside a sphere, including its boundary.
+		/// @param center The center of the sphere.
+		/// @param radius The radius of the sphere.
+		/// @return The handles of the entities.
+		auto InRadius(const P& center, float radius) -> std::vector<Handle> {
+			std::vector<Handle> handles;
+			ForEachInRadius(center, radius, [&](Handle handle, auto&) { handles.push_back(handle); });
+			return handles;
+		}
+
+		/// @brief Get the number of indexed entities.
+		/// @return The number of entities.
+		auto Size() -> size_t { return m_size; }
+
+		/// @brief Get the coordinates of a position, missing coordinates are 0.
+		/// @param pos The position.
+		/// @return The coordinates.
+		static auto Point(const P& pos) -> point_t {
+			if constexpr (requires { pos.x; pos.y; pos.z; }) { return { (float)pos.x, (float)pos.y, (float)pos.z }; }
+			else if constexpr (requires { pos.x; pos.y; }) { return { (float)pos.x, (float)pos.y, 0.0f }; }
+			else {
+				static_assert( std::tuple_size<P>::value == 2 || std::tuple_size<P>::value == 3 ); //position must have 2 or 3 coordinates
+				if constexpr (std::tuple_size<P>::value == 2) { return { (float)pos[0], (float)pos[1], 0.0f }; }
+				else { return { (float)pos[0], (float)pos[1], (float)pos[2] }; }
+			}
+		}
+
+	private:
+		using cell_t = std::array<int64_t, 3>;
+
+		/// @brief Get the cell containing a point.
+		auto Cell(const point_t& p) -> cell_t {
+			return { (int64_t)std::floor(p[0] / m_cellSize), (int64_t)std::floor(p[1] / m_cellSize), (int64_t)std::floor(p[2] / m_cellSize) };
+		}
+
+		/// @brief Pack the coordinates of a cell into a key, 21 bits per axis.
+		static auto Key(const cell_t& cell) -> uint64_t {
+			const uint64_t mask = (1ull << 21) - 1;
+			return (((uint64_t)cell[0] & mask) << 42) | (((uint64_t)cell[1] & mask) << 21) | ((uint64_t)cell[2] & mask);
+		}
+
+		/// @brief Call a function for all entries of all cells overlapping a box. If the box covers more cells than 
+		/// are occupied, the occupied cells are visited instead.
+		void ForEachCell(const point_t& lo, const point_t& hi, auto&& fun) {
+			auto clo = Cell(lo), chi = Cell(hi);
+			double cells = 1.0;
+			for( int i = 0; i < 3; ++i ) { cells *= (double)(chi[i] - clo[i] + 1); }
+			if( cells > (double)m_cells.size() ) {
+				for( auto& [key, entries] : m_cells ) { for( auto& entry : entries ) { fun(entry); } }
+				return;
+			}
+			for( int64_t x = clo[0]; x <= chi[0]; ++x ) {
+				for( int64_t y = clo[1]; y <= chi[1]; ++y ) {
+					for( int64_t z = clo[2]; z <= chi[2]; ++z ) {
+						auto it = m_cells.find( Key({x, y, z}) );
+						if( it != m_cells.end() ) { for( auto& entry : it->second ) { fun(entry); } }
+					}
+				}
+			}
+		}
+
+		float m_cellSize; ///< Edge length of the cells.
+		std::unordered_map<uint64_t, std::vector<Entry>> m_cells; ///< Occupied cells.
+		size_t m_size{0}; ///< Number of entries.
+	}; //end of SpatialIndex
+
+
+	//----------------------------------------------------------------------------------------------
+	//Aggregate
+
+	/// @brief Count, sum, minimum and maximum of the values of component T over all entities of a view, i.e., entities
+	/// that also have the components Ts and match the tag lists. The values are updated incrementally, reading them
+	/// costs O(1). Sums need T to support + and -, minimum and maximum need operator<. Sums of floating point values 
+	/// accumulate rounding errors over many updates.
+	/// @tparam T The type of the aggregated component.
+	/// @tparam Ts Further components the entities must have.
+	template<typename T, typename... Ts>
+	class Aggregate : public IndexBase {
+
+		static const bool has_sum = requires(T a, T b) { a = a + b; a = a - b; };
+		static const bool has_order = requires(T a, T b) { a < b; };
+
+	public:
+		using value_t = T;
+
+		/// @brief Constructor.
+		/// @param yes Entities must have all of these tags.
+		/// @param no Entities must not have any of these tags.
+		Aggregate(std::vector<size_t>&& yes = {}, std::vector<size_t>&& no = {}) : m_yes{std::move(yes)}, m_no{std::move(no)} {}
+
+		bool Matches(Archetype* arch) override {
+			return arch->Has(Type<T>()) && (arch->Has(Type<Ts>()) && ...) 
+				&& std::ranges::all_of(m_yes, [&](size_t tag){ return arch->Has(tag); })
+				&& std::ranges::none_of(m_no, [&](size_t tag){ return arch->Has(tag); });
+		}
+
+		bool DependsOn(size_t ti) override { return ti == Type<T>(); }
+
+		void Add(Handle, Archetype* arch, size_t index) override {
+			auto& value = arch->template Read<T>(index);
+			++m_count;
+			if constexpr (has_sum) { m_sum = m_sum + value; }
+			if constexpr (has_order) { ++m_values[value]; }
+		}
+
+		void Remove(Handle, Archetype* arch, size_t index) override {
+			auto& value = arch->template Read<T>(index);
+			--m_count;
+			if constexpr (has_sum) { m_sum = m_sum - value; }
+			if constexpr (has_order) { 
+				auto it = m_values.find(value);
+				if( it == m_values.end() ) { return; } //the value was written through a reference, see Registry::Ref
+				if( --it->second == 0 ) { m_values.erase(it); }
+			}
+		}
+
+		void Clear() override { m_count = 0; m_sum = T{}; m_values.clear(); }
+
+		/// @brief Get the number of entities in the view.
+		/// @return The number of entities.
+		auto Count() -> size_t { return m_count; }
+
+		/// @brief Get the sum of the values.
+		/// @return The sum, or T{} if the view is empty.
+		auto Sum() -> T requires has_sum { return m_sum; }
+
+		/// @brief Get the smallest value.
+		/// @return The smallest value, or std::nullopt if the view is empty.
+		auto Min() -> std::optional<T> requires has_order { 
+			return m_values.empty() ? std::nullopt : std::optional<T>{ m_values.begin()->first }; 
+		}
+
+		/// @brief Get the largest value.
+		/// @return The largest value, or std::nullopt if the view is empty.
+		auto Max() -> std::optional<T> requires has_order { 
+			return m_values.empty() ? std::nullopt : std::optional<T>{ m_values.rbegin()->first }; 
+		}
+
+	private:
+		struct Empty { void clear() {} };
+		using values_t = std::conditional_t<has_order, std::map<T, size_t>, Empty>;
+
+		std::vector<size_t> m_yes; ///< Entities must have all of these tags.
+		std::vector<size_t> m_no; ///< Entities must not have any of these tags.
+		size_t m_count{0}; ///< Number of entities.
+		T m_sum{}; ///< Sum of the values.
+		values_t m_values; ///< Number of entities per value, for the minimum and maximum.
+	}; //end of Aggregate
+
+
+	//----------------------------------------------------------------------------------------------
+	//Relationships
+
+	/// @brief Component relating an entity to its parent, see Registry::SetParent().
+	struct ChildOf {
+		Handle m_parent;		//the parent
+		bool m_cascade{true};	//if true, erasing the parent erases the child, else the child becomes a root
+	};
+
+	/// @brief Index from parents to their children, maintained from the ChildOf components. The children of a parent 
+	/// are stored contiguously in the order they were added.
+	class ChildrenIndex : public IndexBase {
+
+	public:
+		ChildrenIndex() = default;
+
+		bool Matches(Archetype* arch) override { return arch->Has(Type<ChildOf>()); }
+		bool DependsOn(size_t ti) override { return ti == Type<ChildOf>(); }
+
+		void Add(Handle handle, Archetype* arch, size_t index) override {
+			m_children[arch->template Read<ChildOf>(index).m_parent.GetValue()].push_back(handle);
+			++m_version;
+		}
+
+		void Remove(Handle handle, Archetype* arch, size_t index) override {
+			auto it = m_children.find( arch->template Read<ChildOf>(index).m_parent.GetValue() );
+			if( it == m_children.end() ) { return; }
+			auto& children = it->second;
+			auto child = std::ranges::find_if(children, [&](Handle h) { return h.GetValue() == handle.GetValue(); });
+			if( child != children.end() ) { children.erase(child); } //keep the order
+			if( children.empty() ) { m_children.erase(it); }
+			++m_version;
+		}
+
+		void Clear() override { m_children.clear(); ++m_version; }
+
+		/// @brief Get the version of the index, which changes whenever a relationship changes.
+		/// @return The version.
+		auto Version() -> size_t { return m_version; }
+
+		/// @brief Get the children of a parent.
+		/// @param parent The parent.
+		/// @return The children, invalidated by changing relationships.
+		auto Children(Handle parent) -> std::span<const Handle> {
+			auto it = m_children.find(parent.GetValue());
+			if( it == m_children.end() ) { return {}; }
+			return it->second;
+		}
+
+	private:
+		std::unordered_map<size_t, std::vector<Handle>> m_children; ///< Children by parent handle value.
+		size_t m_version{0}; ///< Changes whenever a relationship changes.
+	}; //end of ChildrenIndex
+
+
+	//----------------------------------------------------------------------------------------------
+	//Hierarchy
+
+	/// @brief The entities having a local component L and a world component W, ordered by their depth in the 
+	/// hierarchy given by the ChildOf components, see Registry::Propagate(). Each depth level stores the handles,
+	/// the positions of the parents in the level above and the last propagated world values contiguously, so 
+	/// a level can be processed in parallel without looking up parents. Writing L or ChildOf marks an entity 
+	/// dirty, inserting or erasing entities or changing parents rebuilds the levels.
+	/// @tparam L The type of the local component.
+	/// @tparam W The type of the world component.
+	template<typename L, typename W>
+	class Hierarchy : public IndexBase {
+
+	public:
+		/// @brief All entities of one depth.
+		struct Level {
+			std::vector<Handle>	  m_handles;	//the entities
+			std::vector<uint32_t> m_parents;	//positions of the parents in the level above
+			std::vector<W>		  m_world;		//last propagated world values
+			std::vector<uint8_t>  m_dirty;		//1 if the entity must be propagated
+		};
+
+		Hierarchy() = default;
+
+		bool Matches(Archetype* arch) override { return arch->Has(Type<L>()) && arch->Has(Type<W>()); }
+		bool DependsOn(size_t ti) override { return ti == Type<L>() || ti == Type<ChildOf>(); }
+
+		void Add(Handle handle, Archetype*, size_t) override {
+			++m_count;
+			auto it = m_positions.find(handle.GetValue());
+			if( it == m_positions.end() ) { m_rebuild = true; return; }
+			m_levels[it->second.first].m_dirty[it->second.second] = 1;
+		}
+
+		void Remove(Handle, Archetype*, size_t) override { --m_count; }
+
+		void Clear() override { m_count = 0; m_rebuild = true; }
+
+		/// @brief Test if the levels must be rebuilt.
+		/// @param childrenVersion Current version of the children index.
+		/// @return true if entities were inserted or erased, or parents changed.
+		bool NeedsRebuild(size_t childrenVersion) {
+			return m_rebuild || m_count != m_positions.size() || childrenVersion != m_childrenVersion;
+		}
+
+		/// @brief Start rebuilding the levels, all entities become dirty.
+		/// @param childrenVersion Current version of the children index.
+		void BeginRebuild(size_t childrenVersion) {
+			for( auto& level : m_levels ) { level = {}; }
+			m_levels.clear();
+			m_positions.clear();
+			m_childrenVersion = childrenVersion;
+			m_rebuild = false;
+		}
+
+		/// @brief Add an entity to the levels while rebuilding. Entities must be added level by level.
+		/// @param handle The entity.
+		/// @param depth Its depth, 0 for roots.
+		/// @param parent Position of the parent in the level above.
+		void Push(Handle handle, size_t depth, uint32_t parent) {
+			if( depth == m_levels.size() ) { m_levels.emplace_back(); }
+			auto& level = m_levels[depth];
+			m_positions[handle.GetValue()] = { depth, level.m_handles.size() };
+			level.m_handles.push_back(handle);
+			level.m_parents.push_back(parent);
+			level.m_world.emplace_back();
+			level.m_dirty.push_back(1);
+		}
+
+		/// @brief Get the depth levels.
+		/// @return Reference to the levels.
+		auto Levels() -> std::vector<Level>& { return m_levels; }
+
+	private:
+		std::vector<Level> m_levels; ///< Entities by depth.
+		std::unordered_map<size_t, std::pair<size_t, size_t>> m_positions; ///< Level and position by handle value.
+		size_t m_count{0}; ///< Number of entities having L and W.
+		size_t m_childrenVersion{0}; ///< Version of the children index the levels were built from.
+		bool m_rebuild{true}; ///< True if an unknown entity was added.
+	}; //end of Hierarchy
+
+} //namespace vecs
@@ -1,24 +1,340 @@
 #pragma once
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+#endif
+
 namespace vecs {
 
 	//----------------------------------------------------------------------------------------------
-	//Mutexes and Locks
+	//Mutexes
+
+	/// @brief Tell the CPU that we are busy waiting. This frees resources for the other hyperthread.
+	inline void CpuRelax() {
+		#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_pause();
+		#elif defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+		#elif defined(__aarch64__) || defined(__arm__)
+			asm volatile("yield");
+		#endif
+	}
+
+	/// @brief Exponential backoff for spin loops. After some rounds the time slice is given up.
+	struct Backoff {
+		static const uint32_t LIMIT = 64; ///< Maximum number of pauses per round.
+
+		/// @brief Wait a bit, and double the waiting time for the next round.
+		void operator()() {
+			if( m_count <= LIMIT ) {
+				for( uint32_t i = 0; i < m_count; ++i ) { CpuRelax(); }
+				m_count *= 2;
+			} else { std::this_thread::yield(); }
+		}
+
+		uint32_t m_count{1}; ///< Number of pauses in the next round.
+	};
+
+	/// @brief Debug check for mutexes without shared mode. Such a mutex deadlocks if a thread locks it again while 
+	/// holding it, also in shared mode, so shared locks must not nest. In debug builds, the owner of the mutex is 
+	/// remembered and locking it twice asserts instead of deadlocking. In release builds, this is empty.
+	class OwnerCheck {
+	public:
+		/// @brief Assert that the calling thread does not hold the mutex. Call this before locking.
+		void CheckNotOwner() {
+			#ifndef NDEBUG
+				assert( m_owner.load(std::memory_order_relaxed) != std::this_thread::get_id() && "Mutex without shared mode locked twice by the same thread!" );
+			#endif
+		}
+
+		/// @brief Remember the calling thread as owner. Call this after locking.
+		void SetOwner() {
+			#ifndef NDEBUG
+				m_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+			#endif
+		}
+
+		/// @brief Forget the owner. Call this before unlocking.
+		void ClearOwner() {
+			#ifndef NDEBUG
+				m_owner.store(std::thread::id{}, std::memory_order_relaxed);
+			#endif
+		}
+
+	private:
+		#ifndef NDEBUG
+			std::atomic<std::thread::id> m_owner{}; ///< Thread that holds the mutex.
+		#endif
+	};
+
+	/// @brief A test-and-test-and-set spinlock with exponential backoff. Waiting threads only read the lock
+	/// until it looks free, so they do not bounce the cache line around. There is no shared mode, 
+	/// lock_shared() locks exclusively, so shared locks must not nest, see OwnerCheck.
+	class SpinMutex : OwnerCheck {
+	public:
+		static constexpr bool SHARED_MODE = false; ///< Shared locks are exclusive, see HasSharedMode().
+
+		void lock() {
+			CheckNotOwner();
+			Backoff backoff;
+			while( m_locked.exchange(true, std::memory_order_acquire) ) {
+				while( m_locked.load(std::memory_order_relaxed) ) { backoff(); }
+			}
+			SetOwner();
+		}
+		bool try_lock() { 
+			if( m_locked.load(std::memory_order_relaxed) || m_locked.exchange(true, std::memory_order_acquire) ) return false;
+			SetOwner();
+			return true;
+		}
+		void unlock() { ClearOwner(); m_locked.store(false, std::memory_order_release); }
+		void lock_shared() { lock(); }
+		bool try_lock_shared() { return try_lock(); }
+		void unlock_shared() { unlock(); }
+
+	private:
+		std::atomic<bool> m_locked{false}; ///< True if the lock is held.
+	};
+
+	/// @brief A fair ticket lock. Threads acquire the lock in the order they arrived. There is no shared mode, 
+	/// lock_shared() locks exclusively, so shared locks must not nest, see OwnerCheck.
+	class TicketMutex : OwnerCheck {
+	public:
+		static constexpr bool SHARED_MODE = false; ///< Shared locks are exclusive, see HasSharedMode().
+
+		void lock() {
+			CheckNotOwner();
+			uint32_t ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+			Backoff backoff;
+			while( m_serving.load(std::memory_order_acquire) != ticket ) { backoff(); }
+			SetOwner();
+		}
+
+		/// @brief Lock the mutex if no thread holds it or waits for it. Only then the next ticket is served right away.
+		/// @return true if the mutex was locked.
+		bool try_lock() {
+			uint32_t ticket = m_serving.load(std::memory_order_acquire);
+			uint32_t next = ticket;
+			if( !m_next.compare_exchange_strong(next, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed) ) return false;
+			SetOwner();
+			return true;
+		}
+		void unlock() { ClearOwner(); m_serving.store(m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+		void lock_shared() { lock(); }
+		bool try_lock_shared() { return try_lock(); }
+		void unlock_shared() { unlock(); }
+
+	private:
+		std::atomic<uint32_t> m_next{0};	///< Next ticket to hand out.
+		std::atomic<uint32_t> m_serving{0}; ///< Ticket that currently holds the lock.
+	};
+
+	/// @brief Find out whether a mutex type has a real shared mode, i.e. several threads can hold shared locks at the
+	/// same time. Mutexes without shared mode declare SHARED_MODE = false.
+	/// @tparam M The mutex type.
+	/// @return true if the mutex has a shared mode.
+	template<typename M>
+	constexpr bool HasSharedMode() {
+		if constexpr (requires { M::SHARED_MODE; }) { return M::SHARED_MODE; }
+		else { return true; }
+	}
+
+	static_assert( !HasSharedMode<SpinMutex>() && !HasSharedMode<TicketMutex>() && HasSharedMode<std::shared_mutex>() );
+
+	/// @brief A reader-writer lock held in a single 32 bit word. Bit 0 is set if a writer holds the lock, bit 1 if a writer
+	/// is waiting, and the remaining bits count the readers. A waiting writer blocks new readers, so writers do not starve.
+	/// If PARK is true, threads that have spun for a while go to sleep on the lock word (std::atomic::wait) instead of 
+	/// yielding, so short critical sections stay in user space and only long waits cost a syscall.
+	/// @tparam PARK If true, waiting threads are parked after spinning.
+	template<bool PARK>
+	class RWSpinMutexT {
+
+		static const uint32_t WRITER = 1;	///< A writer holds the lock.
+		static const uint32_t WAITING = 2;	///< A writer waits for the lock.
+		static const uint32_t READER = 4;	///< One reader.
+		static const uint32_t SPINS = 16;	///< Spin rounds before parking.
+		static constexpr auto RELEASE = PARK ? std::memory_order_seq_cst : std::memory_order_release; ///< Unlock order, must not pass the check for parked threads.
+
+	public:
+		void lock() {
+			Backoff backoff;
+			for( uint32_t round = 0; ; ++round ) {
+				uint32_t state = m_state.load(std::memory_order_relaxed);
+				if( (state & ~WAITING) == 0 ) {
+					if( m_state.compare_exchange_weak(state, WRITER, std::memory_order_acquire) ) return;
+					continue;
+				}
+				if( !(state & WAITING) ) { m_state.fetch_or(WAITING, std::memory_order_relaxed); }
+				Wait(state | WAITING, round, backoff);
+			}
+		}
+
+		bool try_lock() {
+			uint32_t state = m_state.load(std::memory_order_relaxed);
+			return (state & ~WAITING) == 0 && m_state.compare_exchange_strong(state, WRITER, std::memory_order_acquire);
+		}
+
+		void unlock() {
+			m_state.fetch_and(~WRITER, RELEASE);
+			Wake();
+		}
+
+		void lock_shared() {
+			Backoff backoff;
+			for( uint32_t round = 0; ; ++round ) {
+				uint32_t state = m_state.load(std::memory_order_relaxed);
+				if( !(state & (WRITER | WAITING)) ) {
+					if( m_state.compare_exchange_weak(state, state + READER, std::memory_order_acquire) ) return;
+					continue;
+				}
+				Wait(state, round, backoff);
+			}
+		}
+
+		void unlock_shared() {
+			if( m_state.fetch_sub(READER, RELEASE) == (READER | WAITING) ) { Wake(); } //last reader, writer waits
+		}
+
+	private:
+
+		/// @brief Wait until the lock word changes. Spin first, then park or yield.
+		void Wait(uint32_t state, uint32_t round, Backoff& backoff) {
+			if constexpr (PARK) {
+				if( round >= SPINS ) {
+					m_parked.fetch_add(1, std::memory_order_seq_cst);
+					m_state.wait(state, std::memory_order_relaxed);
+					m_parked.fetch_sub(1, std::memory_order_relaxed);
+					return;
+				}
+			}
+			backoff();
+		}
+
+		/// @brief Wake up parked threads, if there are any.
+		void Wake() {
+			if constexpr (PARK) {
+				if( m_parked.load(std::memory_order_seq_cst) > 0 ) { m_state.notify_all(); }
+			}
+		}
+
+		std::atomic<uint32_t> m_state{0};	///< Writer bits and reader count.
+		std::atomic<uint32_t> m_parked{0};	///< Number of parked threads, only used if PARK is true.
+	};
+
+	using RWSpinMutex = RWSpinMutexT<false>;	///< Reader-writer spinlock.
+	using HybridMutex = RWSpinMutexT<true>;		///< Reader-writer lock that spins first and then parks.
+
+	/// @brief The mutex type used by archetypes and slot maps. Select it by defining one of MUTEXTYPE_SPIN, MUTEXTYPE_TICKET,
+	/// MUTEXTYPE_RWSPIN or MUTEXTYPE_HYBRID before including VECS.h. Default is std::shared_mutex.
+	#if defined(MUTEXTYPE_SPIN)
+		using Mutex_t = SpinMutex;
+	#elif defined(MUTEXTYPE_TICKET)
+		using Mutex_t = TicketMutex;
+	#elif defined(MUTEXTYPE_RWSPIN)
+		using Mutex_t = RWSpinMutex;
+	#elif defined(MUTEXTYPE_HYBRID)
+		using Mutex_t = HybridMutex;
+	#else
+		using Mutex_t = std::shared_mutex;
+	#endif
+
+	//----------------------------------------------------------------------------------------------
+	//Cache lines and counters
+
+	const size_t CACHE_LINE_SIZE = 64; ///< Size of a cache line, used to keep data written by different threads apart.
+
+	/// @brief A value that occupies its own cache line(s), so writing it does not invalidate neighboring data.
+	/// @tparam T The type of the value.
+	template<typename T>
+	struct alignas(CACHE_LINE_SIZE) CacheLinePadded {
+		T m_value{}; ///< The padded value.
+	};
+
+	/// @brief Get a small index for the calling thread. Threads are numbered in the order they first call this function.
+	/// @return The index of the thread.
+	inline size_t ThreadIndex() {
+		static std::atomic<size_t> next{0};
+		thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+
+	/// @brief A counter made of per-thread accumulators. Each thread adds to its own stripe on its own cache line,
+	/// reading the counter sums up all stripes. Single stripes may become negative, the sum cannot.
+	/// @tparam N Number of stripes, a power of 2.
+	/// @tparam T Type of a stripe, either int64_t or std::atomic<int64_t>.
+	template<size_t N, typename T>
+		requires (N > 0 && (N & (N - 1)) == 0)
+	class StripedCounter {
+	public:
+		/// @brief Add a value to the stripe of the calling thread.
+		/// @param value The value to add, can be negative.
+		void Add(int64_t value) {
+			auto& stripe = m_stripes[ThreadIndex() & (N - 1)].m_value;
+			if constexpr (std::is_integral_v<T>) { stripe += value; } 
+			else { stripe.fetch_add(value, std::memory_order_relaxed); }
+		}
+
+		/// @brief Get the sum of all stripes.
+		/// @return The value of the counter.
+		auto Get() const -> size_t {
+			int64_t sum = 0;
+			for( auto& stripe : m_stripes ) { sum += stripe.m_value; }
+			return (size_t)sum;
+		}
+
+		/// @brief Set the counter to zero.
+		void Reset() {
+			for( auto& stripe : m_stripes ) { stripe.m_value = 0; }
+		}
+
+	private:
+		std::array<CacheLinePadded<T>, N> m_stripes; ///< One stripe per thread (modulo N).
+	};
+
+	//----------------------------------------------------------------------------------------------
+	//Locks
 
 	const int LOCKGUARDTYPE_SEQUENTIAL = 0;
 	const int LOCKGUARDTYPE_PARALLEL = 1;
 
+	#ifdef REGISTRYTYPE_PARALLEL
+		const int LOCKGUARDTYPE = LOCKGUARDTYPE_PARALLEL; ///< Lock guard type matching the registry type.
+	#else
+		const int LOCKGUARDTYPE = LOCKGUARDTYPE_SEQUENTIAL; ///< Lock guard type matching the registry type.
+	#endif
+
+	/// @brief Load a value that other threads change concurrently with StoreRelease(), e.g. for optimistic readers, 
+	/// see SeqLock. In sequential mode this is a plain load.
+	/// @param value Reference to the value.
+	/// @return The value.
+	template<typename T>
+	inline auto LoadAcquire(const T& value) -> T {
+		if constexpr (LOCKGUARDTYPE == LOCKGUARDTYPE_PARALLEL) { 
+			return std::atomic_ref<T>(const_cast<T&>(value)).load(std::memory_order_acquire); 
+		} else { return value; }
+	}
+
+	/// @brief Store a value that other threads load concurrently with LoadAcquire(). In sequential mode this is a plain store.
+	/// @param ref Reference to the value.
+	/// @param value The new value.
+	template<typename T>
+	inline void StoreRelease(T& ref, T value) {
+		if constexpr (LOCKGUARDTYPE == LOCKGUARDTYPE_PARALLEL) { std::atomic_ref<T>(ref).store(value, std::memory_order_release); } 
+		else { ref = value; }
+	}
+
 	/// @brief An exclusive lock guard for a mutex, meaning that only one thread can lock the mutex at a time.
 	/// A LockGuard is used to lock and unlock a mutex in a RAII manner.
 	/// In case of two simultaneous locks, the mutexes are locked in the correct order to avoid deadlocks.
 	/// @tparam LTYPE Type of the lock guard.
-	template<int LTYPE>
+	/// @tparam M Type of the mutex.
+	template<int LTYPE, typename M = Mutex_t>
 		requires (LTYPE == LOCKGUARDTYPE_SEQUENTIAL || LTYPE == LOCKGUARDTYPE_PARALLEL)
 	struct LockGuard {
 
 		/// @brief Constructor for a single mutex.
 		/// @param mutex Pointer to the mutex.
-		LockGuard(Mutex_t* mutex) : m_mutex{mutex}, m_other{nullptr} { 
+		LockGuard(M* mutex) : m_mutex{mutex}, m_other{nullptr} { 
 			if constexpr (LTYPE == LOCKGUARDTYPE_PARALLEL) { 
 				if(mutex) m_mutex->lock(); 
 			}
@@ -28,7 +344,7 @@ namespace vecs {
 		/// the entity components change. In this case, two mutexes must be locked.
 		/// @param mutex Pointer to the mutex.
 		/// @param other Pointer to the other mutex.
-		LockGuard(Mutex_t* mutex, Mutex_t* other) : m_mutex{mutex}, m_other{other} { 
+		LockGuard(M* mutex, M* other) : m_mutex{mutex}, m_other{other} { 
 			if constexpr (LTYPE == LOCKGUARDTYPE_PARALLEL) {
 				if(mutex && other) { 
 					std::min(m_mutex, m_other)->lock();	///lock the mutexes in the correct order
@@ -47,19 +363,20 @@ namespace vecs {
 			}
 		}
 
-		Mutex_t* m_mutex{nullptr};
-		Mutex_t* m_other{nullptr};
+		M* m_mutex{nullptr};
+		M* m_other{nullptr};
 	};
 
 	/// @brief A lock guard for a shared mutex in RAII manner. Several threads can lock the mutex in shared mode at the same time.
 	/// This is used to make sure that data structures are not modified while they are read.
 	/// @tparam LTYPE Type of the lock guard.
-	template<int LTYPE>
+	/// @tparam M Type of the mutex.
+	template<int LTYPE, typename M = Mutex_t>
 		requires (LTYPE == LOCKGUARDTYPE_SEQUENTIAL || LTYPE == LOCKGUARDTYPE_PARALLEL)
 	struct LockGuardShared {
 
 		/// @brief Constructor for a single mutex, locks the mutex.
-		LockGuardShared(Mutex_t* mutex) : m_mutex{mutex} { 
+		LockGuardShared(M* mutex) : m_mutex{mutex} { 
 			if constexpr (LTYPE == LOCKGUARDTYPE_PARALLEL) { m_mutex->lock_shared(); }
 		}
 
@@ -68,10 +385,10 @@ namespace vecs {
 			if constexpr (LTYPE == LOCKGUARDTYPE_PARALLEL) { m_mutex->unlock_shared(); }
 		}
 
-		Mutex_t* m_mutex{nullptr}; ///< Pointer to the mutex.
+		M* m_mutex{nullptr}; ///< Pointer to the mutex.
 	};
 
-	template<int LTYPE>
+	template<int LTYPE, typename M = Mutex_t>
 		requires (LTYPE == LOCKGUARDTYPE_SEQUENTIAL || LTYPE == LOCKGUARDTYPE_PARALLEL)
 	struct UnlockGuardShared {
 
@@ -93,8 +410,69 @@ namespace vecs {
 			}
 		}
 
-		Mutex_t* m_mutex{nullptr}; ///< Pointer to the mutex.
+		M* m_mutex{nullptr}; ///< Pointer to the mutex.
 	};
 
+	//----------------------------------------------------------------------------------------------
+	//Sequence Locks
+
+	/// @brief A sequence lock for optimistic reading. Writers increase the sequence number before and after writing,
+	/// so it is odd while a write is in progress. Readers do not write to the lock at all. They remember the sequence 
+	/// number, read the data, and retry if the number has changed in between. Writers must be serialized by other means.
+	class SeqLock {
+	public:
+		/// @brief Start reading. Waits until no write is in progress.
+		/// @return The sequence number to validate the read with.
+		auto ReadBegin() const -> size_t {
+			Backoff backoff;
+			size_t seq = m_sequence.load(std::memory_order_acquire);
+			while( seq & 1 ) { 
+				backoff(); 
+				seq = m_sequence.load(std::memory_order_acquire);
+			}
+			return seq;
+		}
+
+		/// @brief Test whether data read since ReadBegin() may be inconsistent.
+		/// @param seq The sequence number returned by ReadBegin().
+		/// @return true if a write happened in between and the read must be repeated, else false.
+		bool ReadRetry(size_t seq) const {
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return m_sequence.load(std::memory_order_relaxed) != seq;
+		}
+
+		/// @brief Start writing, the sequence number becomes odd.
+		void WriteBegin() {
+			m_sequence.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		/// @brief Finish writing, the sequence number becomes even.
+		void WriteEnd() {
+			m_sequence.fetch_add(1, std::memory_order_release);
+		}
+
+	private:
+		std::atomic<size_t> m_sequence{0}; ///< Sequence number, odd while writing.
+	};
+
+	/// @brief Marks a write to data protected by a sequence lock in RAII manner. Is empty in sequential mode.
+	/// @tparam LTYPE Type of the lock guard.
+	template<int LTYPE>
+		requires (LTYPE == LOCKGUARDTYPE_SEQUENTIAL || LTYPE == LOCKGUARDTYPE_PARALLEL)
+	struct SeqLockGuard {
+
+		/// @brief Constructor, starts the write.
+		SeqLockGuard(SeqLock* lock) : m_lock{lock} {
+			if constexpr (LTYPE == LOCKGUARDTYPE_PARALLEL) { if(m_lock) m_lock->WriteBegin(); }
+		}
+
+		/// @brief Destructor, ends the write.
+		~SeqLockGuard() {
+			if constexpr (LTYPE == LOCKGUARDTYPE_PARALLEL) { if(m_lock) m_lock->WriteEnd(); }
+		}
+
+		SeqLock* m_lock{nullptr}; ///< Pointer to the sequence lock.
+	};
 
 }
@@ -30,23 +30,27 @@ namespace vecs {
 			size_t m_hash;				//hash of the set
 		};
 
+		/// @brief A slot map stripe with its mutex. Stripes start on their own cache lines, and the mutex 
+		/// is kept apart from the free list and size fields of the slot map.
 		template<vecs::VecsPOD T>
-		struct SlotMapAndMutex {
+		struct alignas(CACHE_LINE_SIZE) SlotMapAndMutex {
 			SlotMap<T> m_slotMap;
-			Mutex_t m_mutex;
+			alignas(CACHE_LINE_SIZE) Mutex_t m_mutex;
 			SlotMapAndMutex( uint32_t storageIndex, uint32_t bits ) : m_slotMap{storageIndex, bits}, m_mutex{} {};
 			SlotMapAndMutex( const SlotMapAndMutex& other ) : m_slotMap{other.m_slotMap}, m_mutex{} {};
 		};
 
 		#ifdef REGISTRYTYPE_SEQUENTIAL
 			using NUMBER_SLOTMAPS = std::integral_constant<int, 1>;
+			using Counter_t = StripedCounter<1, int64_t>;
 		#else
 			using NUMBER_SLOTMAPS = std::integral_constant<int, 16>;
+			using Counter_t = StripedCounter<16, std::atomic<int64_t>>;
 		#endif
 
 		using Slot_t = typename SlotMap<typename Archetype::ArchetypeAndIndex>::Slot;
 		using SlotMaps_t = std::vector<SlotMapAndMutex<typename Archetype::ArchetypeAndIndex>>;
-		using HashMap_t = std::map<size_t, std::unique_ptr<Archetype>>;
+		using HashMap_t = ArchetypeMap;
 
 	public:	
 
@@ -56,39 +60,62 @@ namespace vecs {
 			requires (!std::is_reference_v<U>)
 		class Ref {
 
-			using T = std::decay_t<U>;
+			using T = component_value_t<U>;
 
 		public:
 			Ref() = default;
-			Ref(Handle handle, Slot_t& slot) : m_handle{handle}, m_slot{&slot}, m_archetype{slot.m_value.m_arch} {}
-			Ref(const Ref& other) : m_handle{other.m_handle}, m_slot{other.m_slot}, m_archetype{other.m_archetype} {}
+			Ref(Handle handle, Registry& registry) : m_handle{handle}, m_registry{&registry} { m_archetype = CachedSlot().m_value.m_arch; }
+			Ref(const Ref& other) : m_handle{other.m_handle}, m_registry{other.m_registry}, m_archetype{other.m_archetype}, 
+				m_slot{other.m_slot}, m_epoch{other.m_epoch} {}
 
-			bool IsValid() { return m_slot != nullptr; }
-			bool Exists() { return m_slot->m_version == m_handle.GetVersion(); }
+			bool IsValid() { return m_registry != nullptr; }
+			bool Exists() { return m_registry->Exists(m_handle); }
 			auto operator()() -> T& {return GetReference(); }
-			auto operator=(T&& value) -> void { GetReference() = std::forward<T>(value); }
+			auto operator=(T&& value) -> void { 
+				auto& ref = GetReference();
+				auto& archAndIndex = m_slot->m_value; //cached by GetReference()
+				m_registry->template Write<U>(m_handle, archAndIndex.m_arch, archAndIndex.m_index, [&]() {
+					SeqLockGuard<LOCKGUARDTYPE> guard(&archAndIndex.m_arch->GetSeqLock());
+					ref = std::forward<T>(value); 
+				});
+			}
 			     operator T&() { return GetReference(); }
 			auto Value() -> T& { return GetReference(); }
 			auto Get() -> T& { return GetReference(); }
 
 		private:
 			auto GetReference() -> T& {
-				auto arch = m_slot->m_value.m_arch;
-				auto index = m_slot->m_value.m_index;
-				if( !m_slot || m_slot->m_version != m_handle.GetVersion() || ( arch != m_archetype && !arch->Has(Type<T>()) )  ) {
-					if( !arch->Has(Type<T>()) ) {
+				auto& slot = CachedSlot();
+				auto arch = slot.m_value.m_arch;
+				auto index = slot.m_value.m_index;
+				if( slot.m_version != m_handle.GetVersion() || ( arch != m_archetype && !arch->Has(Type<U>()) )  ) {
+					if( !arch || !arch->Has(Type<U>()) ) {
 						std::cout << "Reference to type " << typeid(std::declval<T>()).name() << " invalidated because of adding or erasing a component or erasing an entity!" << std::endl;
 						assert(false);
 						exit(-1);
 					}
 					m_archetype = arch;
 				}
-				return (*arch->template Map<T>())[index];
+				return (*arch->template Map<U>())[index];
+			}
+
+			/// @brief Get the slot of the entity. The address of the slot is cached, and looked up again only if a segment
+			/// of the slot map was replaced or freed since, e.g. cloned after a snapshot, see Vector<T>::epoch().
+			/// @return Reference to the slot.
+			auto CachedSlot() -> const Slot_t& {
+				auto& slotMap = std::as_const(m_registry->m_slotMaps[m_handle.GetStorageIndex()].m_slotMap);
+				if( m_slot == nullptr || slotMap.Epoch() != m_epoch ) {
+					m_slot = &slotMap[m_handle];
+					m_epoch = slotMap.Epoch();
+				}
+				return *m_slot;
 			}
 
 			Handle m_handle{};
-			Slot_t* m_slot{nullptr};
+			Registry* m_registry{nullptr};
 			Archetype *m_archetype{nullptr};
+			const Slot_t* m_slot{nullptr};	//cached slot of the entity, see CachedSlot()
+			size_t m_epoch{0};				//epoch of the slot map when the slot was cached
 		};
 
 		//----------------------------------------------------------------------------------------------
@@ -101,13 +128,21 @@ namespace vecs {
 
 		public:
 			Ref() = default;		
-			Ref(Handle handle, Slot_t& slot) : m_handle{handle}, m_slot{&slot}, m_archetype{slot.m_value.m_arch} {}
-			Ref(const Ref& other) : m_handle{other.m_handle}, m_slot{other.m_slot}, m_archetype{other.m_archetype} {}
+			Ref(Handle handle, Registry& registry) : m_handle{handle}, m_registry{&registry} { m_archetype = CachedSlot().m_value.m_arch; }
+			Ref(const Ref& other) : m_handle{other.m_handle}, m_registry{other.m_registry}, m_archetype{other.m_archetype}, 
+				m_slot{other.m_slot}, m_epoch{other.m_epoch} {}
 
-			bool IsValid() { return m_slot != nullptr; }
-			bool Exists() { return m_slot->m_version == m_handle.GetVersion(); }
+			bool IsValid() { return m_registry != nullptr; }
+			bool Exists() { return m_registry->Exists(m_handle); }
 			auto operator()() -> U& {return GetReference()(); }
-			auto operator=(T&& value) -> void { GetReference()() = std::forward<T>(value); }
+			auto operator=(T&& value) -> void { 
+				auto& ref = GetReference();
+				auto& archAndIndex = m_slot->m_value; //cached by GetReference()
+				m_registry->template Write<T>(m_handle, archAndIndex.m_arch, archAndIndex.m_index, [&]() {
+					SeqLockGuard<LOCKGUARDTYPE> guard(&archAndIndex.m_arch->GetSeqLock());
+					ref() = std::forward<T>(value); 
+				});
+			}
 			     operator T&() { return GetReference(); }
 				 operator U&() { return GetReference()(); }
 			auto Value() -> U& { return GetReference()(); }
@@ -115,9 +150,10 @@ namespace vecs {
 
 		private:
 			auto GetReference() -> T& {
-				auto arch = m_slot->m_value.m_arch;
-				auto index = m_slot->m_value.m_index;
-				if( !m_slot || m_slot->m_version != m_handle.GetVersion() || ( arch != m_archetype && !arch->Has(Type<T>()) ) ) {
+				auto& slot = CachedSlot();
+				auto arch = slot.m_value.m_arch;
+				auto index = slot.m_value.m_index;
+				if( slot.m_version != m_handle.GetVersion() || ( arch != m_archetype && !arch->Has(Type<T>()) ) ) {
 					std::cout << "Reference to type " << typeid(std::declval<T>()).name() << " invalidated because of adding or erasing a component or erasing an entity!" << std::endl;
 					assert(false);
 					exit(-1);
@@ -128,13 +164,31 @@ namespace vecs {
 				return (*arch->template Map<T>())[index];
 			}
 
+			/// @brief Get the slot of the entity. The address of the slot is cached, and looked up again only if a segment
+			/// of the slot map was replaced or freed since, e.g. cloned after a snapshot, see Vector<T>::epoch().
+			/// @return Reference to the slot.
+			auto CachedSlot() -> const Slot_t& {
+				auto& slotMap = std::as_const(m_registry->m_slotMaps[m_handle.GetStorageIndex()].m_slotMap);
+				if( m_slot == nullptr || slotMap.Epoch() != m_epoch ) {
+					m_slot = &slotMap[m_handle];
+					m_epoch = slotMap.Epoch();
+				}
+				return *m_slot;
+			}
+
 			Handle m_handle{};
-			Slot_t* m_slot{nullptr};
-			Archetype *m_archetype{nullptr};		
+			Registry* m_registry{nullptr};
+			Archetype *m_archetype{nullptr};
+			const Slot_t* m_slot{nullptr};	//cached slot of the entity, see CachedSlot()
+			size_t m_epoch{0};				//epoch of the slot map when the slot was cached
 		};
 
 		template<typename T>
-		using to_ref_t = std::conditional<std::is_reference_v<T>, Ref<std::decay_t<T>>, T>::type;
+		using to_ref_t = std::conditional<std::is_reference_v<T>, Ref<std::decay_t<T>>, component_value_t<T>>::type;
+
+		/// @brief True if values of these types are read optimistically, see is_read_mostly.
+		template<typename... Ts>
+		static constexpr bool OPTIMISTIC = LOCKGUARDTYPE == LOCKGUARDTYPE_PARALLEL && ((!std::is_reference_v<Ts> && is_read_mostly<Ts>::value) && ...);
 
 
 		//----------------------------------------------------------------------------------------------
@@ -161,6 +215,7 @@ namespace vecs {
 			Iterator( Registry& system, std::vector<ArchetypeAndSize>& arch, size_t archidx) 
 				: m_registry(system), m_archetypes{arch}, m_archidx{archidx}, m_entidx{0} {
 				m_archidx>0 ? m_end = true : m_end = false;
+				if( !m_end ) { Skip(); }
 			}
 
 			/// @brief Copy constructor.
@@ -179,13 +234,8 @@ namespace vecs {
 			auto operator++() {
 				if( m_archidx >= m_archetypes.size() ) { return *this; }
 				++m_entidx;
+				Skip();
 				Archetype::m_iteratingIndex = m_entidx;
-				while( m_entidx >= m_archetypes[m_archidx].m_arch->Number() || m_entidx >= m_archetypes[m_archidx].m_size ) {
-					m_entidx = 0;
-					m_registry.FillGaps(m_archetypes[m_archidx].m_arch);
-					++m_archidx;
-					if( m_archidx >= m_archetypes.size() ) { break; }
-				}
 				return *this;
 			}
 
@@ -208,18 +258,34 @@ namespace vecs {
 
 		private:
 
+			/// @brief Go to the next row that holds an entity. Rows of erased entities are gaps with invalid handles.
+			void Skip() {
+				while( m_archidx < m_archetypes.size() ) {
+					auto [arch, size] = m_archetypes[m_archidx];
+					if( m_entidx < arch->Number() && m_entidx < size ) {
+						if( !arch->HasGaps() || arch->template Read<Handle>(m_entidx).IsValid() ) { return; }
+						++m_entidx;
+						continue;
+					}
+					m_entidx = 0;
+					m_registry.FillGaps(arch);
+					++m_archidx;
+				}
+			}
+
 			template<typename T>
 				requires (!std::is_reference_v<T>)
-			auto Get() -> T {
-				return (*m_archetypes[m_archidx].m_arch->template Map<T>())[m_entidx];
+			auto Get() -> component_value_t<T> {
+				if constexpr (OPTIMISTIC<T>) { return m_archetypes[m_archidx].m_arch->template ReadOptimistic<T>(m_entidx); }
+				else return m_archetypes[m_archidx].m_arch->template Read<T>(m_entidx);
 			}
 
 			template<typename T>
 				requires std::is_reference_v<T>
 			auto Get() -> to_ref_t<T> {
 				auto arch = m_archetypes[m_archidx].m_arch;
-				Handle handle = (*arch->template Map<Handle>())[m_entidx];
-				return to_ref_t<T>( handle, m_registry.GetSlot(handle));
+				Handle handle = arch->template Read<Handle>(m_entidx);
+				return to_ref_t<T>( handle, m_registry );
 			}
 
 			Registry& m_registry; ///< Reference to the registry system.
@@ -240,16 +306,94 @@ namespace vecs {
 
 		public:
 			View(Registry& system, HashMap_t& map, auto&& tagsYes, auto&& tagsNo ) : 
-				m_system{system}, m_map(map), m_tagsYes{tagsYes}, m_tagsNo{tagsNo} {
+				m_system{system}, m_map(map), m_tagsYes{tagsYes}, m_tagsNo{tagsNo}, m_archetypes{AcquireViewVector()} {
 			} ///< Constructor.
 
+			~View() { ReleaseViewVector(std::move(m_archetypes)); } ///< Destructor, returns the archetype list to the pool.
+
 			/// @brief Get an iterator to the first entity. 
 			/// The archetype is locked in shared mode to prevent changes. 
 			/// @return Iterator to the first entity.
 			auto begin() {
+				Collect();
+				return Iterator<Ts...>{m_system, m_archetypes, 0};
+			}
+
+			/// @brief Get an iterator to the end of the view.
+			auto end() {
+				return Iterator<Ts...>{m_system, m_archetypes, m_archetypes.size()};
+			}
+
+			/// @brief Count the entities of the view. Costs O(number of archetypes).
+			/// @return The number of entities.
+			auto Count() -> size_t {
+				Collect();
+				size_t count = 0;
+				for( auto& [arch, size] : m_archetypes ) { count += arch->Size(); }
+				return count;
+			}
+
+			/// @brief Map all entities of the view to values and combine them, in parallel. The rows of the archetypes are
+			/// cut into chunks of fixed size, every chunk is reduced by one thread, and the chunk results are combined in 
+			/// archetype and row order. So the result does not depend on the number of threads, even if combine is not 
+			/// associative, like adding floats. The view must not be changed while reducing.
+			/// @param init The start value of every chunk, must be neutral for combine.
+			/// @param map Function mapping the component values of an entity to a value of type R.
+			/// @param combine Function combining two values of type R.
+			/// @param chunk Number of rows per chunk.
+			/// @return The combined value, or init if the view is empty.
+			template<typename R>
+			auto Reduce(R init, auto&& map, auto&& combine, size_t chunk = 1 << 14) -> R {
+				Collect();
+				std::vector<std::pair<Archetype*, size_t>> chunks; //archetype and first row
+				for( auto& [arch, size] : m_archetypes ) {
+					for( size_t row = 0; row < size; row += chunk ) { chunks.emplace_back(arch, row); }
+				}
+				std::vector<R> results(chunks.size(), init);
+				ParallelFor(chunks.size(), [&](size_t i) {
+					auto [arch, first] = chunks[i];
+					size_t last = std::min(first + chunk, arch->Number());
+					R result = init;
+					for( size_t row = first; row < last; ++row ) {
+						if( arch->HasGaps() && !arch->template Read<Handle>(row).IsValid() ) { continue; } //skip gaps
+						result = combine(std::move(result), map(arch->template Read<std::decay_t<Ts>>(row)...));
+					}
+					results[i] = std::move(result);
+				});
+				for( auto& result : results ) { init = combine(std::move(init), std::move(result)); }
+				return init;
+			}
+
+			/// @brief Call a function for all entities of the view, including runtime components, see RegisterComponent().
+			/// The ids must be yes tags of the view, so all entities have these components. The columns are resolved 
+			/// once per archetype. The view must not be changed while iterating.
+			/// @param ids The ids of the runtime components.
+			/// @param fun Function called with the component values of an entity, and a span of pointers to its runtime
+			/// component values in the order of the ids.
+			void ForEachRaw(std::span<const size_t> ids, auto&& fun) {
+				Collect();
+				std::vector<RawVector*> columns(ids.size());
+				std::vector<void*> values(ids.size());
+				for( auto& [arch, size] : m_archetypes ) {
+					for( size_t i = 0; i < ids.size(); ++i ) {
+						assert( arch->Has(ids[i]) );
+						columns[i] = static_cast<RawVector*>(arch->Map(ids[i]));
+					}
+					for( size_t row = 0; row < size; ++row ) {
+						if( arch->HasGaps() && !arch->template Read<Handle>(row).IsValid() ) { continue; } //skip gaps
+						for( size_t i = 0; i < ids.size(); ++i ) { values[i] = (*columns[i])[row]; }
+						fun(arch->template Get<Ts>(row)..., std::span<void* const>{values});
+					}
+				}
+			}
+
+		private:
+
+			/// @brief Collect the archetypes of the view.
+			void Collect() {
 				m_archetypes.clear();
-				for( auto& map : m_map ) { //go through all archetypes
-					auto arch = map.second.get();
+				for( auto& entry : m_map ) { //go through all archetypes
+					auto arch = entry.m_arch.get();
 					if( arch->Size() == 0 ) { continue; } //skip empty archetypes
 					bool hasTypes = (arch->Has(Type<Ts>()) && ...); //should have all types
 					bool hasAllTagsYes = true; //should have all tags
@@ -257,19 +401,11 @@ namespace vecs {
 					for( auto& tag : m_tagsYes ) { if( !arch->Has(tag) ) { hasAllTagsYes = false; break; } }
 					for( auto& tag : m_tagsNo ) { if( arch->Has(tag) ) { hasNoTagsNo = false; break; } }
 					if( hasTypes && hasAllTagsYes && hasNoTagsNo ) { //all conditions met
-						m_archetypes.push_back({arch, arch->Size()});
+						m_archetypes.push_back({arch, arch->Number()}); //including gaps, the iterator skips them
 					}
 				}
-				return Iterator<Ts...>{m_system, m_archetypes, 0};
 			}
 
-			/// @brief Get an iterator to the end of the view.
-			auto end() {
-				return Iterator<Ts...>{m_system, m_archetypes, m_archetypes.size()};
-			}
-
-		private:
-
 			Registry& 				m_system;	///< Reference to the registry system.
 			std::vector<size_t> 			m_tagsYes;	///< List of tags that must be present.
 			std::vector<size_t> 			m_tagsNo;	///< List of tags that must not be present.
@@ -278,15 +414,235 @@ namespace vecs {
 		}; //end of View
 
 
+		//----------------------------------------------------------------------------------------------
+
+		/// @brief Collects component values, component erasures and tag changes for an entity, and applies them with 
+		/// Commit() in one step: the target archetype is looked up once, and the entity is moved once, constructing
+		/// the new components in place. Building an entity with Insert(), several Put() and AddTags() instead moves 
+		/// it through all intermediate archetypes. Builders are created by Registry::Build(). 
+		/// @tparam Ts The types of the collected component values.
+		template<typename... Ts>
+		class Builder {
+
+			template<typename... Us> friend class Builder;
+
+		public:
+			Builder(Registry& registry, Handle handle, std::tuple<Ts...>&& values, std::vector<size_t>&& tags, std::vector<size_t>&& erase) 
+				: m_registry{registry}, m_handle{handle}, m_values{std::move(values)}, m_tags{std::move(tags)}, m_erase{std::move(erase)} {}
+
+			/// @brief Add a component, or overwrite it if the entity has it already.
+			/// @param value The value of the component.
+			/// @return A builder that also holds the value.
+			template<typename T>
+				requires (!vtll::has_type< vtll::tl<Ts...>, std::decay_t<T>>::value && !std::is_same_v<std::decay_t<T>, Handle>)
+			[[nodiscard]] auto Put(T&& value) -> Builder<Ts..., std::decay_t<T>> {
+				return { m_registry, m_handle, std::tuple_cat(std::move(m_values), std::tuple<std::decay_t<T>>{std::forward<T>(value)}), 
+					std::move(m_tags), std::move(m_erase) };
+			}
+
+			/// @brief Erase components from the entity.
+			/// @tparam Us The types of the components.
+			/// @return Reference to the builder.
+			template<typename... Us>
+			auto Erase() -> Builder& {
+				(m_erase.push_back(Type<Us>()), ...);
+				return *this;
+			}
+
+			/// @brief Add tags to the entity.
+			/// @param tags The tags.
+			/// @return Reference to the builder.
+			auto AddTags(std::convertible_to<size_t> auto... tags) -> Builder& {
+				(m_tags.push_back(tags), ...);
+				return *this;
+			}
+
+			/// @brief Erase tags from the entity.
+			/// @param tags The tags.
+			/// @return Reference to the builder.
+			auto EraseTags(std::convertible_to<size_t> auto... tags) -> Builder& {
+				(m_erase.push_back(tags), ...);
+				return *this;
+			}
+
+			/// @brief Apply all changes.
+			/// @return The handle of the entity, or an invalid handle if the entity does not exist or the registry has a
+			/// fixed capacity that would be exceeded.
+			auto Commit() -> Handle {
+				return std::apply( [&](auto&&... vs) { return m_registry.Commit(m_handle, std::move(m_tags), std::move(m_erase), std::move(vs)...); }, std::move(m_values) );
+			}
+
+		private:
+			Registry& 			m_registry;	///< The registry.
+			Handle 				m_handle;	///< The entity, invalid for a new entity.
+			std::tuple<Ts...>	m_values;	///< Component values to put.
+			std::vector<size_t>	m_tags;		///< Tags to add.
+			std::vector<size_t>	m_erase;	///< Components and tags to erase.
+		}; //end of Builder
+
+
+		//----------------------------------------------------------------------------------------------
+
+		/// @brief A read-only snapshot of the registry, see Registry::Snapshot(). The snapshot shares all segments of 
+		/// the component maps and slot maps copy-on-write with the registry. Writing to the registry clones only 
+		/// the segments that are written to, so the snapshot stays consistent and can be read by other threads 
+		/// while the registry keeps changing.
+		class SnapshotView {
+
+			friend class Registry;
+
+		public:
+
+			/// @brief Iterator over the entities of a snapshot view, yields component values.
+			template<typename... Ts>
+			class Iterator {
+
+			public:
+				Iterator(std::vector<Archetype*>& archetypes, size_t archidx) : m_archetypes{archetypes}, m_archidx{archidx} { Skip(); }
+
+				auto operator++() { ++m_entidx; Skip(); return *this; }
+
+				auto operator*() {
+					auto arch = m_archetypes[m_archidx];
+					if constexpr (sizeof...(Ts) == 1) { return arch->template Read<Ts...>(m_entidx); }
+					else return std::tuple<component_value_t<Ts>...>{ arch->template Read<Ts>(m_entidx)... };
+				}
+
+				auto operator!=(const Iterator& other) -> bool {
+					return (m_archidx != other.m_archidx) || (m_entidx != other.m_entidx);
+				}
+
+			private:
+				/// @brief Go to the next row that holds an entity, rows of erased entities have invalid handles.
+				void Skip() {
+					while( m_archidx < m_archetypes.size() ) {
+						auto arch = m_archetypes[m_archidx];
+						while( m_entidx < arch->Number() && !arch->template Read<Handle>(m_entidx).IsValid() ) { ++m_entidx; }
+						if( m_entidx < arch->Number() ) { return; }
+						m_entidx = 0;
+						++m_archidx;
+					}
+				}
+
+				std::vector<Archetype*>& m_archetypes; ///< List of archetypes.
+				size_t m_archidx{0};	///< Index of the current archetype.
+				size_t m_entidx{0};		///< Index of the current entity.
+			};
+
+			/// @brief A view of the snapshot entities with specific components.
+			template<typename... Ts>
+			class View {
+
+			public:
+				View(std::vector<Archetype*>&& archetypes) : m_archetypes{std::move(archetypes)} {}
+				auto begin() { return Iterator<Ts...>{m_archetypes, 0}; }
+				auto end() { return Iterator<Ts...>{m_archetypes, m_archetypes.size()}; }
+
+			private:
+				std::vector<Archetype*> m_archetypes; ///< Snapshot archetypes that have all types.
+			};
+
+			/// @brief Constructor, creates the snapshot. Costs O(number of segments).
+			/// @param registry The registry to take the snapshot of.
+			SnapshotView(Registry& registry) : m_size{registry.Size()} {
+				for( auto& entry : registry.m_archetypes ) {
+					m_archetypes.push_back(entry.m_arch->Snapshot());
+					m_remap[entry.m_arch.get()] = m_archetypes.back().get();
+				}
+				m_slotMaps.reserve(registry.m_slotMaps.size());
+				for( auto& slotmap : registry.m_slotMaps ) { m_slotMaps.push_back(slotmap.m_slotMap.Snapshot()); }
+			}
+
+			/// @brief Get the number of entities in the snapshot.
+			/// @return The number of entities.
+			size_t Size() { return m_size; }
+
+			/// @brief Test if an entity existed when the snapshot was taken.
+			/// @param handle The handle of the entity.
+			/// @return true if the entity exists, else false.
+			bool Exists(Handle handle) {
+				auto& slotmap = m_slotMaps[handle.GetStorageIndex()];
+				if( handle.GetIndex() >= slotmap.Capacity() ) { return false; } //entity was created after the snapshot
+				auto& slot = std::as_const(slotmap)[handle];
+				return slot.m_version == handle.GetVersion() && slot.m_value.m_arch != nullptr; //free slots have no archetype
+			}
+
+			/// @brief Test if an entity has a component.
+			/// @tparam T The type of the component.
+			/// @param handle The handle of the entity.
+			/// @return true if the entity has the component, else false.
+			template<typename T>
+			bool Has(Handle handle) {
+				assert(Exists(handle));
+				return GetArchetypeAndIndex(handle).m_arch->Has(Type<T>());
+			}
+
+			/// @brief Get component values of an entity.
+			/// @tparam Ts The types of the components, the entity must have all of them.
+			/// @param handle The handle of the entity.
+			/// @return The component value, or a tuple of the component values.
+			template<typename... Ts>
+				requires (sizeof...(Ts) > 0 && (!std::is_reference_v<Ts> && ...))
+			[[nodiscard]] auto Get(Handle handle) {
+				assert(Exists(handle));
+				auto [arch, index] = GetArchetypeAndIndex(handle);
+				assert( (arch->Has(Type<Ts>()) && ...) );
+				if constexpr (sizeof...(Ts) == 1) { return arch->template Read<Ts...>(index); }
+				else return std::tuple<component_value_t<Ts>...>{ arch->template Read<Ts>(index)... };
+			}
+
+			/// @brief Get a view of the snapshot entities with specific components.
+			/// @tparam ...Ts The types of the components.
+			/// @param yes Tags that the entities must have.
+			/// @param no Tags that the entities must not have.
+			/// @return A view of the entity components.
+			template<typename... Ts>
+				requires (sizeof...(Ts) > 0 && (!std::is_reference_v<Ts> && ...))
+			[[nodiscard]] auto GetView(std::vector<size_t>&& yes={}, std::vector<size_t>&& no={}) -> View<Ts...> {
+				std::vector<Archetype*> archetypes;
+				for( auto& arch : m_archetypes ) {
+					if( arch->Number() == 0 || !(arch->Has(Type<Ts>()) && ...) ) { continue; }
+					if( std::ranges::any_of(yes, [&](size_t tag){ return !arch->Has(tag); }) ) { continue; }
+					if( std::ranges::any_of(no, [&](size_t tag){ return arch->Has(tag); }) ) { continue; }
+					archetypes.push_back(arch.get());
+				}
+				return { std::move(archetypes) };
+			}
+
+		private:
+			/// @brief Get the snapshot archetype and the index of an entity.
+			/// @param handle The handle of the entity.
+			/// @return The snapshot archetype and the index of the entity in it.
+			auto GetArchetypeAndIndex(Handle handle) -> Archetype::ArchetypeAndIndex {
+				auto& value = std::as_const(m_slotMaps[handle.GetStorageIndex()])[handle].m_value;
+				return { m_remap.at(value.m_arch), value.m_index }; //the slot points to the live archetype
+			}
+
+			size_t m_size; ///< Number of entities.
+			std::vector<std::unique_ptr<Archetype>> m_archetypes; ///< Snapshots of the archetypes.
+			std::unordered_map<Archetype*, Archetype*> m_remap; ///< Maps live archetypes to their snapshots.
+			std::vector<SlotMap<typename Archetype::ArchetypeAndIndex>> m_slotMaps; ///< Snapshots of the slot maps.
+		}; //end of SnapshotView
+
+
 		//----------------------------------------------------------------------------------------------
 
 		template<typename... Ts> friend class Iterator;
 
-		Registry() { 
+		/// @brief Constructor. If maximum numbers are given, the registry has a fixed capacity and does not allocate 
+		/// in steady state. The slot maps and the archetype table are preallocated, and each archetype preallocates
+		/// its component maps for maxEntities entities when it is created. Operations that would exceed the maximums
+		/// fail: Insert() returns an invalid handle, Put(), AddTags(), EraseTags() and Erase<Ts...>() return false.
+		/// @param maxEntities Maximum number of entities, 0 if unlimited.
+		/// @param maxArchetypes Maximum number of archetypes, 0 if unlimited.
+		Registry(size_t maxEntities = 0, size_t maxArchetypes = 0) : m_maxEntities{maxEntities}, m_maxArchetypes{maxArchetypes} { 
+			size_t bits = 6;
+			if( maxEntities > 0 ) { bits = std::bit_width( (maxEntities + NUMBER_SLOTMAPS::value - 1) / NUMBER_SLOTMAPS::value - 1 ); }
 			m_slotMaps.reserve(NUMBER_SLOTMAPS::value); //resize the slot storage
 			for( uint32_t i = 0; i < NUMBER_SLOTMAPS::value; ++i ) {
-				m_slotMaps.emplace_back( SlotMapAndMutex<typename Archetype::ArchetypeAndIndex>{ i, 6  } ); 
+				m_slotMaps.emplace_back( SlotMapAndMutex<typename Archetype::ArchetypeAndIndex>{ i, (uint32_t)bits } ); 
 			}
+			if( maxArchetypes > 0 ) { m_archetypes.reserve(maxArchetypes); }
 		};
 
 		~Registry() = default;	///< Destructor.
@@ -294,7 +650,7 @@ namespace vecs {
 		/// @brief Get the number of entities in the system.
 		/// @return The number of entities.
 		size_t Size() {
-			return m_size;
+			return m_size.Get();
 		}
 
 		/// @brief Create an entity with components.
@@ -304,20 +660,59 @@ namespace vecs {
 		template<typename... Ts>
 			requires ((sizeof...(Ts) > 0) && (vtll::unique<vtll::tl<Ts...>>::value) && !vtll::has_type< vtll::tl<Ts...>, Handle>::value)
 		[[nodiscard]] auto Insert( Ts&&... component ) -> Handle {
-			size_t slotMapIndex = GetNewSlotmapIndex();
-			auto [handle, slot] = m_slotMaps[slotMapIndex].m_slotMap.Insert( {nullptr, 0} ); //get a slot for the entity
-			slot.m_value.m_arch = GetArchetype<Ts...>(nullptr, {}, {});
-			slot.m_value.m_index = slot.m_value.m_arch->Insert( handle, std::forward<Ts>(component)... ); //insert the entity into the archetype
-			++m_size;
-			return handle;
+			return Insert2( {}, std::forward<Ts>(component)... );
+		}
+
+		/// @brief Create an entity with components that are constructed in place in their columns, so each component
+		/// is constructed exactly once. Each component type gets a tuple of constructor arguments.
+		/// @tparam Ts The types of the components.
+		/// @param args Tuples of constructor arguments, e.g. made with std::forward_as_tuple().
+		/// @return Handle of new entity.
+		template<typename... Ts, typename... Args>
+			requires ((sizeof...(Ts) > 0) && sizeof...(Ts) == sizeof...(Args) && (vtll::unique<vtll::tl<Ts...>>::value) 
+				&& !vtll::has_type< vtll::tl<Ts...>, Handle>::value && (requires { std::tuple_size<std::decay_t<Args>>::value; } && ...))
+		[[nodiscard]] auto Emplace( Args&&... args ) -> Handle {
+			return Insert2( {}, InPlace<Ts, std::decay_t<Args>>{ std::forward<Args>(args) }... );
+		}
+
+		/// @brief Add a component to an entity, constructed in place in its column. If the entity has the component 
+		/// already, a value is constructed from the arguments and assigned to it.
+		/// @tparam T The type of the component.
+		/// @param handle The handle of the entity.
+		/// @param args The constructor arguments.
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
+		template<typename T, typename... Args>
+			requires (!std::is_same_v<std::decay_t<T>, Handle>)
+		bool Emplace( Handle handle, Args&&... args ) {
+			assert(Exists(handle));
+			auto& archAndIndex = GetArchetypeAndIndex(handle);
+			auto arch = archAndIndex.m_arch;
+			if( arch->Has(Type<T>()) ) {
+				Write<T>(handle, arch, archAndIndex.m_index, [&]() {
+					SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+					arch->Put(archAndIndex.m_index, T(std::forward<Args>(args)...));
+				});
+				return true;
+			}
+			auto newArch = GetArchetype<T>(arch, {}, {});
+			return Move(newArch, arch, archAndIndex, InPlace<T, std::tuple<Args&&...>>{ std::forward_as_tuple(std::forward<Args>(args)...) });
+		}
+
+		/// @brief Create an entity builder, see Builder. 
+		/// @param handle The entity to change, or an invalid handle to create a new entity.
+		/// @return The builder.
+		[[nodiscard]] auto Build(Handle handle = {}) -> Builder<> {
+			return Builder<>{*this, handle, {}, {}, {}};
 		}
 
 		/// @brief Test if an entity exists.
 		/// @param handle The handle of the entity.
 		/// @return true if the entity exists, else false.
 		bool Exists(Handle handle) {
-			auto& slot = GetSlot(handle);
-			return slot.m_version == handle.GetVersion();
+			auto& slotmap = std::as_const(m_slotMaps[handle.GetStorageIndex()].m_slotMap);
+			if( handle.GetIndex() >= slotmap.Capacity() ) { return false; } //slot was removed by Rewind()
+			auto& slot = slotmap[handle];
+			return slot.m_version == handle.GetVersion() && slot.m_value.m_arch != nullptr; //free slots have no archetype
 		}
 
 		/// @brief Test if an entity has a component.
@@ -350,7 +745,8 @@ namespace vecs {
 			return arch->Types();
 		}
 
-		/// @brief Get a component value of an entity.
+		/// @brief Get a component value of an entity. If the entity does not have the component, it is added. With a
+		/// fixed capacity, the destination archetype must have room, else the program is terminated.
 		/// @tparam T The type of the component.
 		/// @param handle The handle of the entity.
 		/// @return The component value or reference to it.
@@ -359,7 +755,7 @@ namespace vecs {
 			return std::get<0>(Get2<T>(handle));
 		}
 
-		/// @brief Get component values of an entity.
+		/// @brief Get component values of an entity. Missing components are added, see Get<T>().
 		/// @tparam Ts The types of the components.
 		/// @param handle The handle of the entity.
 		/// @return A tuple of the component values.
@@ -369,96 +765,618 @@ namespace vecs {
 			return Get2<Ts...>(handle);
 		}
 
+		/// @brief Get component values of many entities at once. The entities are grouped by archetype and sorted by
+		/// their index, so each group resolves its columns once and reads them in ascending order. Slots and values 
+		/// are prefetched a few entities ahead. Unlike Get(), this never adds components to entities. Like Get(), reads
+		/// are synchronized with writers only for read mostly components, which are read optimistically. Handles are 
+		/// resolved to rows once up front, so GetMany() must not run alongside inserts, erasures or other changes that 
+		/// move entities; optimistic reads only guard against concurrent writes of the values.
+		/// @tparam Ts The types of the components.
+		/// @param handles The handles of the entities.
+		/// @param out Receives the values, out[i] belongs to handles[i]. Must be at least as large as handles. Values of 
+		/// entities that do not exist or lack a component are left unchanged.
+		/// @return The number of entities whose values were written.
+		template<typename... Ts>
+			requires ((sizeof...(Ts) > 0) && vtll::unique<vtll::tl<Ts...>>::value && (!std::is_reference_v<Ts> && ...))
+		auto GetMany(std::span<const Handle> handles, std::span<gather_t<Ts...>> out) -> size_t {
+			assert(out.size() >= handles.size());
+			auto& gather = Gather(handles);
+			size_t found = 0;
+			for( size_t begin = 0, end = 0; begin < gather.size(); begin = end ) {
+				auto arch = gather[begin].m_arch;
+				for( end = begin + 1; end < gather.size() && gather[end].m_arch == arch; ++end ) {}
+				if( !(arch->Has(Type<Ts>()) && ...) ) { continue; }
+				std::tuple<Vector<component_value_t<Ts>>*...> columns{ arch->template Map<Ts>()... }; //once per group
+				for( size_t i = begin; i < end; ++i ) {
+					if( i + PREFETCH_DISTANCE < end ) {
+						std::apply([&](auto... col) { (VECS_PREFETCH(col->address(gather[i + PREFETCH_DISTANCE].m_index)), ...); }, columns);
+					}
+					auto& value = out[gather[i].m_pos];
+					if constexpr (OPTIMISTIC<Ts...>) {
+						std::tuple<component_value_t<Ts>...> values;
+						while( !arch->template TryRead<Ts...>(gather[i].m_index, arch->GetSeqLock().ReadBegin(), values) ) {}
+						if constexpr (sizeof...(Ts) == 1) { value = std::get<0>(values); } else { value = values; }
+					} else {
+						std::apply([&](auto... col) { value = gather_t<Ts...>{ std::as_const(*col)[gather[i].m_index]... }; }, columns);
+					}
+				}
+				found += end - begin;
+			}
+			return found;
+		}
+
+		/// @brief Put component values to many entities at once. The entities are grouped by archetype and sorted by 
+		/// their index. A group whose archetype has the component resolves the column once, marks the writes for 
+		/// optimistic readers once with the archetype's sequence lock, and writes the values in ascending order, 
+		/// prefetching a few entities ahead. Like Put(), writes to the same entity from several threads must be 
+		/// synchronized by the caller, and no archetype mutex is taken, so indexes can lock their own mutexes. A group 
+		/// whose archetype lacks the component looks up the destination archetype once, and each move constructs the
+		/// new value directly in its slot. Since a move into a full archetype fills one of its gaps, which moves another 
+		/// entity, rows are looked up again when written. If a handle occurs several times, the last value wins.
+		/// @tparam T The type of the component.
+		/// @param handles The handles of the entities.
+		/// @param values The values, values[i] is put to handles[i]. Must be at least as large as handles.
+		/// @return The number of entities that were written. Entities that do not exist are skipped, and so are
+		/// entities that would exceed a fixed capacity.
+		template<typename T>
+			requires (std::is_same_v<T, std::decay_t<T>> && !std::is_same_v<T, Handle>)
+		auto PutMany(std::span<const Handle> handles, std::span<const T> values) -> size_t {
+			assert(values.size() >= handles.size());
+			auto& gather = Gather(handles);
+			size_t written = 0;
+			for( size_t begin = 0, end = 0; begin < gather.size(); begin = end ) {
+				auto arch = gather[begin].m_arch;
+				for( end = begin + 1; end < gather.size() && gather[end].m_arch == arch; ++end ) {}
+				if( arch->Has(Type<T>()) ) {
+					SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+					auto column = arch->template Map<T>(); //once per group
+					for( size_t i = begin; i < end; ++i ) {
+						if( i + PREFETCH_DISTANCE < end ) { VECS_PREFETCH(column->address(gather[i + PREFETCH_DISTANCE].m_index)); }
+						auto handle = handles[gather[i].m_pos];
+						auto index = GetArchetypeAndIndex(handle).m_index; //a move of an earlier group may have filled a gap
+						Write<T>(handle, arch, index, [&]() { (*column)[index] = values[gather[i].m_pos]; });
+					}
+					written += end - begin;
+					continue;
+				}
+				auto newArch = GetArchetype<T>(arch, {}, {}); //once per group
+				for( size_t i = begin; i < end; ++i ) {
+					auto handle = handles[gather[i].m_pos];
+					auto& value = values[gather[i].m_pos];
+					auto& archAndIndex = GetArchetypeAndIndex(handle); //indexes change while the group is moved
+					if( archAndIndex.m_arch != arch ) { written += Put2(handle, value) ? 1 : 0; } //moved already
+					else { written += Move(newArch, arch, archAndIndex, value) ? 1 : 0; }
+				}
+			}
+			return written;
+		}
+
 		/// @brief Put new component values to an entity.
 		/// @tparam Ts The types of the components.
 		/// @param handle The handle of the entity.
 		/// @param v The new values in a tuple
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
 		template<typename... Ts>
 			requires (vtll::unique<vtll::tl<Ts...>>::value && !vtll::has_type< vtll::tl<std::decay_t<Ts>...>, Handle>::value)
-		void Put(Handle handle, std::tuple<Ts...>& v) {
-			Put2(handle, std::forward<Ts>(std::get<Ts>(v))...);
+		bool Put(Handle handle, std::tuple<Ts...>& v) {
+			return Put2(handle, std::forward<Ts>(std::get<Ts>(v))...);
 		}
 
 		/// @brief Put new component values to an entity.
 		/// @tparam Ts The types of the components.
 		/// @param handle The handle of the entity.
 		/// @param ...vs The new values.
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
 		template<typename... Ts>
 			requires ((vtll::unique<vtll::tl<Ts...>>::value) && !vtll::has_type< vtll::tl<std::decay_t<Ts>...>, Handle>::value)
-		void Put(Handle handle, Ts&&... vs) {
-			Put2(handle, std::forward<Ts>(vs)...);
+		bool Put(Handle handle, Ts&&... vs) {
+			return Put2(handle, std::forward<Ts>(vs)...);
 		}
 
 		/// @brief Add tags to an entity.
 		/// @tparam ...Ts The types of the tags.
 		/// @param handle The handle of the entity.
 		/// @param ...tags The tags to add.
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
 		template<typename... Ts>
 			requires (std::is_integral_v<std::decay_t<Ts>> && ...)
-		void AddTags(Handle handle, Ts... tags) {
-			AddTags(handle, std::vector<size_t>{tags...});
+		bool AddTags(Handle handle, Ts... tags) {
+			return AddTags(handle, std::vector<size_t>{tags...});
 		}
 		
 		/// @brief Add tags to an entity.
 		/// @param handle The handle of the entity.
 		/// @param tags The tags to add.
 		/// @param ...tags The tags to add.
-		void AddTags(Handle handle, const std::vector<size_t>&& tags) {
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
+		bool AddTags(Handle handle, const std::vector<size_t>&& tags) {
 			auto& archAndIndex = GetArchetypeAndIndex(handle);
 			auto oldArch = archAndIndex.m_arch;
 			auto newArch = GetArchetype(oldArch, std::forward<decltype(tags)>(tags), {});
-			Move(newArch, oldArch, archAndIndex);
+			return Move(newArch, oldArch, archAndIndex);
 		}
 
 		/// @brief Erase tags from an entity.
 		/// @tparam ...Ts The types of the tags.
 		/// @param handle The handle of the entity.
 		/// @param ...tags The tags to erase.
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
 		template<typename... Ts>
 			requires (std::is_integral_v<std::decay_t<Ts>> && ...)
-		void EraseTags(Handle handle, Ts... tags) {
-			EraseTags(handle, std::vector<size_t>{tags...});
+		bool EraseTags(Handle handle, Ts... tags) {
+			return EraseTags(handle, std::vector<size_t>{tags...});
 		}
 
 		/// @brief Erase tags from an entity.
 		/// @tparam ...Ts The types of the tags.
 		/// @param handle The handle of the entity.
 		/// @param ...tags The tags to erase.
-		void EraseTags(Handle handle, const std::vector<size_t>&& tags) {
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
+		bool EraseTags(Handle handle, const std::vector<size_t>&& tags) {
 			auto& archAndIndex = GetArchetypeAndIndex(handle);
 			auto oldArch = archAndIndex.m_arch;
 			auto newArch = GetArchetype(oldArch, {}, std::forward<decltype(tags)>(tags));
-			Move(newArch, oldArch, archAndIndex);
+			return Move(newArch, oldArch, archAndIndex);
+		}
+
+		/// @brief Register a component type that is defined at runtime. Its values are stored in a RawVector column 
+		/// and accessed by id as untyped pointers. Ids can be used like tags: AddTags() adds a default constructed 
+		/// value, EraseTags() erases the component, and views select entities with it by passing the id as yes tag.
+		/// Register all runtime components before using them, registering is not thread safe.
+		/// @param desc The description of the type. If the name is registered already, the existing type is kept.
+		/// @return The id of the component.
+		auto RegisterComponent(ComponentDescriptor desc) -> size_t {
+			assert( std::has_single_bit(desc.m_align) );
+			size_t id = desc.Id();
+			if( auto it = m_components.find(id); it != m_components.end() ) {
+				assert( it->second->m_size == desc.m_size && it->second->m_align == desc.m_align );
+				return id;
+			}
+			m_components.emplace(id, std::make_shared<const ComponentDescriptor>(std::move(desc)));
+			return id;
+		}
+
+		/// @brief Get the description of a runtime component.
+		/// @param id The id of the component.
+		/// @return Pointer to the description, or nullptr if the id is not registered.
+		auto GetDescriptor(size_t id) -> const ComponentDescriptor* {
+			auto it = m_components.find(id);
+			return it != m_components.end() ? it->second.get() : nullptr;
+		}
+
+		/// @brief Put a runtime component value to an entity. If the entity does not have the component, it is added.
+		/// @param handle The handle of the entity.
+		/// @param id The id of the component.
+		/// @param value Pointer to the value, it is copied.
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
+		bool PutRaw(Handle handle, size_t id, const void* value) {
+			assert( Exists(handle) && m_components.contains(id) );
+			auto& archAndIndex = GetArchetypeAndIndex(handle);
+			auto arch = archAndIndex.m_arch;
+			if( !arch->Has(id) ) {
+				auto newArch = GetArchetype(arch, std::vector<size_t>{id}, {});
+				if( !Move(newArch, arch, archAndIndex) ) { return false; }
+				arch = newArch;
+			}
+			SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+			static_cast<RawVector*>(arch->Map(id))->assign(archAndIndex.m_index, value);
+			return true;
+		}
+
+		/// @brief Get a runtime component value of an entity for reading and writing. Unlike Get(), this never adds
+		/// the component. The pointer is valid until the entity is moved or erased.
+		/// @param handle The handle of the entity.
+		/// @param id The id of the component.
+		/// @return Pointer to the value, or nullptr if the entity does not have the component.
+		auto GetRaw(Handle handle, size_t id) -> void* {
+			assert( Exists(handle) );
+			auto& archAndIndex = GetArchetypeAndIndex(handle);
+			if( !archAndIndex.m_arch->Has(id) || !m_components.contains(id) ) { return nullptr; }
+			return (*static_cast<RawVector*>(archAndIndex.m_arch->Map(id)))[archAndIndex.m_index];
 		}
 		
 		/// @brief Erase components from an entity.
 		/// @tparam ...Ts The types of the components.
 		/// @param handle The handle of the entity.		
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
 		template<typename... Ts>
 			requires (vtll::unique<vtll::tl<Ts...>>::value && !vtll::has_type< vtll::tl<Ts...>, Handle>::value)
-		void Erase(Handle handle) {
+		bool Erase(Handle handle) {
 			auto& archAndIndex = GetArchetypeAndIndex(handle);
 			auto arch = archAndIndex.m_arch;
 			assert( (arch->Has(Type<Ts>()) && ...) );
 			auto newArch = GetArchetype(arch, {}, std::vector<size_t>{Type<Ts>()...});	
-			Move(newArch, arch, archAndIndex);		
+			return Move(newArch, arch, archAndIndex);		
 		}
 
 		/// @brief Erase an entity from the registry.
 		/// @param handle The handle of the entity.
 		void Erase(Handle handle) {
+			if( m_children ) { EraseChildren(handle); }
 			auto& slot = GetSlot(handle);
 			auto& archAndIndex = slot.m_value;
+			Removed(handle, archAndIndex.m_arch, archAndIndex.m_index);
+			SeqLockGuard<LOCKGUARDTYPE> guard(&archAndIndex.m_arch->GetSeqLock());
 			ReindexMovedEntity(archAndIndex.m_arch->Erase(archAndIndex.m_index), archAndIndex.m_index);
-			slot.m_version++; //invalidate the slot
-			--m_size;		
+			m_slotMaps[handle.GetStorageIndex()].m_slotMap.Erase(handle); //invalidate the slot and put it into the free list
+			m_size.Add(-1);
 		}
 
 		/// @brief Clear the registry by removing all entities.
 		void Clear() {
-			for( auto& arch : m_archetypes ) { arch.second->Clear(); }
+			for( auto& entry : m_archetypes ) { 
+				SeqLockGuard<LOCKGUARDTYPE> guard(&entry.m_arch->GetSeqLock());
+				entry.m_arch->Clear(); 
+			}
 			for( auto& slotmap : m_slotMaps ) { slotmap.m_slotMap.Clear(); }
-			m_size = 0;
+			for( auto& index : m_indexes ) { index->Clear(); }
+			m_timers.Clear(); //slots can be reused with the same versions
+			m_size.Reset();
+		}
+
+		/// @brief Take a read-only snapshot of the registry. The snapshot shares all segments copy-on-write, so taking it 
+		/// costs O(number of segments). It can be read by other threads while the registry keeps changing. 
+		/// No other thread may write to the registry while the snapshot is taken.
+		/// @return The snapshot.
+		[[nodiscard]] auto Snapshot() -> SnapshotView {
+			return SnapshotView{*this};
+		}
+
+		/// @brief Compute a deterministic hash of the whole registry state, e.g. to detect desyncs in lockstep simulations.
+		/// Archetypes are hashed in parallel in the canonical order of their type signatures, empty archetypes are skipped.
+		/// Gaps are skipped too, so the hash does not depend on whether Maintain() has run.
+		/// The slot maps are hashed including versions and free lists. The results are combined in a fixed order.
+		/// No other thread may write to the registry meanwhile.
+		/// @return The hash.
+		auto Checksum() -> size_t {
+			std::vector<ArchetypeMap::Entry*> entries;
+			for( auto& entry : m_archetypes ) { if( entry.m_arch->Size() > 0 ) { entries.push_back(&entry); } }
+			std::ranges::sort(entries, [](auto* a, auto* b) { 
+				return a->m_hash != b->m_hash ? a->m_hash < b->m_hash : a->m_types < b->m_types; 
+			});
+			std::vector<size_t> sums(entries.size() + m_slotMaps.size());
+			ParallelFor(sums.size(), [&](size_t i) {
+				if( i < entries.size() ) { sums[i] = entries[i]->m_arch->Checksum(entries[i]->m_hash); }
+				else { sums[i] = m_slotMaps[i - entries.size()].m_slotMap.Checksum(i - entries.size()); }
+			});
+			size_t seed = Size();
+			for( auto sum : sums ) { seed = HashCombine(seed, sum); }
+			return seed;
+		}
+
+		/// @brief Create a hash index on the values of component T, see HashIndex. The index is filled with all entities 
+		/// having T, and is maintained on Insert(), Put(), assigning to a Ref, moving entities and Erase(). Values written 
+		/// through references returned by a Ref are not seen by the index. If the index exists already, it is returned.
+		/// @tparam T The type of the component.
+		/// @param unique If true, at most one entity can have a value.
+		/// @return Reference to the index.
+		template<typename T>
+		auto CreateIndex(bool unique = false) -> HashIndex<T>& {
+			auto it = m_hashIndexes.find(Type<T>());
+			if( it != m_hashIndexes.end() ) { return *static_cast<HashIndex<T>*>(it->second); }
+			return AddIndex( std::make_unique<HashIndex<T>>(unique), m_hashIndexes );
+		}
+
+		/// @brief Create an ordered index on the values of component T, see OrderedIndex. It is maintained like
+		/// a hash index, see CreateIndex(). If the index exists already, it is returned.
+		/// @tparam T The type of the component.
+		/// @return Reference to the index.
+		template<typename T>
+		auto CreateOrderedIndex() -> OrderedIndex<T>& {
+			auto it = m_orderedIndexes.find(Type<T>());
+			if( it != m_orderedIndexes.end() ) { return *static_cast<OrderedIndex<T>*>(it->second); }
+			return AddIndex( std::make_unique<OrderedIndex<T>>(), m_orderedIndexes );
+		}
+
+		/// @brief Create a spatial index on the positions stored in component P, see SpatialIndex. It is maintained like
+		/// a hash index, see CreateIndex(). If the index exists already, it is returned.
+		/// @tparam P The type of the position component.
+		/// @param cellSize Edge length of the grid cells.
+		/// @return Reference to the index.
+		template<typename P>
+		auto CreateSpatialIndex(float cellSize) -> SpatialIndex<P>& {
+			auto it = m_spatialIndexes.find(Type<P>());
+			if( it != m_spatialIndexes.end() ) { return *static_cast<SpatialIndex<P>*>(it->second); }
+			return AddIndex( std::make_unique<SpatialIndex<P>>(cellSize), m_spatialIndexes );
+		}
+
+		/// @brief Create an aggregate over the values of component T in the view of the entities having T and Ts and 
+		/// matching the tag lists, see Aggregate. It is maintained like an index, see CreateIndex(). If an aggregate 
+		/// with the same view exists already, it is returned.
+		/// @tparam T The type of the aggregated component.
+		/// @tparam Ts Further components the entities must have.
+		/// @param yes Entities must have all of these tags.
+		/// @param no Entities must not have any of these tags.
+		/// @return Reference to the aggregate.
+		template<typename T, typename... Ts>
+		auto CreateAggregate(std::vector<size_t>&& yes = {}, std::vector<size_t>&& no = {}) -> Aggregate<T, Ts...>& {
+			std::vector<size_t> key{ Type<T>(), Type<Ts>()..., 0 }; //the view definition
+			key.insert(key.end(), yes.begin(), yes.end());
+			key.push_back(0);
+			key.insert(key.end(), no.begin(), no.end());
+			auto it = m_aggregates.find(key);
+			if( it != m_aggregates.end() ) { return *static_cast<Aggregate<T, Ts...>*>(it->second); }
+			auto aggregate = std::make_unique<Aggregate<T, Ts...>>(std::move(yes), std::move(no));
+			auto& ref = *aggregate;
+			Rebuild(aggregate.get());
+			m_aggregates[std::move(key)] = aggregate.get();
+			m_indexes.push_back(std::move(aggregate));
+			return ref;
+		}
+
+		/// @brief Find an entity by the value of component T, see CreateIndex(). Costs O(1).
+		/// @tparam T The type of the component, must be indexed.
+		/// @param value The value.
+		/// @return The handle of an entity with this value, or an invalid handle if there is none.
+		template<typename T>
+		auto Find(const T& value) -> Handle {
+			auto index = GetHashIndex<T>();
+			LockGuardShared<LOCKGUARDTYPE> lock(&index->GetMutex());
+			return index->Find(value);
+		}
+
+		/// @brief Find all entities with a value of component T, see CreateIndex().
+		/// @tparam T The type of the component, must be indexed.
+		/// @param value The value.
+		/// @return The handles of all entities with this value.
+		template<typename T>
+		auto FindAll(const T& value) -> std::vector<Handle> {
+			auto index = GetHashIndex<T>();
+			LockGuardShared<LOCKGUARDTYPE> lock(&index->GetMutex());
+			return index->FindAll(value);
+		}
+
+		/// @brief Find all entities with a value of component T in [lo, hi), see CreateOrderedIndex(). Costs O(log n) plus
+		/// the number of found entities.
+		/// @tparam T The type of the component, must have an ordered index.
+		/// @param lo Smallest value, or std::nullopt for no lower bound.
+		/// @param hi Value after the largest value, or std::nullopt for no upper bound.
+		/// @return The handles of the entities, ordered by value.
+		template<typename T>
+		auto FindRange(const std::optional<T>& lo, const std::optional<T>& hi) -> std::vector<Handle> {
+			auto it = m_orderedIndexes.find(Type<T>());
+			assert( it != m_orderedIndexes.end() ); //call CreateOrderedIndex<T>() first
+			auto index = static_cast<OrderedIndex<T>*>(it->second);
+			LockGuardShared<LOCKGUARDTYPE> lock(&index->GetMutex());
+			return index->Range(lo, hi);
+		}
+
+		/// @brief Find all entities whose position is inside a sphere, see CreateSpatialIndex(). Use Get() to read 
+		/// their components.
+		/// @tparam P The type of the position component, must have a spatial index.
+		/// @param center The center of the sphere.
+		/// @param radius The radius of the sphere.
+		/// @return The handles of the entities.
+		template<typename P>
+		auto FindInRadius(const P& center, float radius) -> std::vector<Handle> {
+			auto index = GetSpatialIndex<P>();
+			LockGuardShared<LOCKGUARDTYPE> lock(&index->GetMutex());
+			return index->InRadius(center, radius);
+		}
+
+		/// @brief Find all entities whose position is inside an axis aligned box, see CreateSpatialIndex().
+		/// @tparam P The type of the position component, must have a spatial index.
+		/// @param lo The corner with the smallest coordinates.
+		/// @param hi The corner with the largest coordinates.
+		/// @return The handles of the entities.
+		template<typename P>
+		auto FindInBox(const P& lo, const P& hi) -> std::vector<Handle> {
+			auto index = GetSpatialIndex<P>();
+			LockGuardShared<LOCKGUARDTYPE> lock(&index->GetMutex());
+			return index->InBox(lo, hi);
+		}
+
+		/// @brief Make an entity the child of another entity by putting a ChildOf component on it. The children of an
+		/// entity can then be enumerated with GetChildren(). Erasing the parent also erases the child if cascade is
+		/// true, otherwise only the ChildOf component of the child is erased.
+		/// @param child The handle of the child.
+		/// @param parent The handle of the parent, or an invalid handle to make the child a root.
+		/// @param cascade If true, erasing the parent erases the child.
+		/// @return false if the child or the parent does not exist, if the parent is the child or one of its descendants, 
+		/// or if the registry has a fixed capacity that would be exceeded, else true.
+		bool SetParent(Handle child, Handle parent, bool cascade = true) {
+			if( !Exists(child) ) { return false; }
+			GetChildrenIndex();
+			if( !parent.IsValid() ) { return !Has<ChildOf>(child) || Erase<ChildOf>(child); }
+			if( !Exists(parent) ) { return false; }
+			for( auto ancestor = parent; ancestor.IsValid(); ancestor = GetParent(ancestor) ) { //prevent cycles
+				if( ancestor.GetValue() == child.GetValue() ) { return false; }
+			}
+			return Put(child, ChildOf{parent, cascade});
+		}
+
+		/// @brief Get the parent of an entity, see SetParent().
+		/// @param child The handle of the entity.
+		/// @return The handle of the parent, or an invalid handle if the entity is a root.
+		[[nodiscard]] auto GetParent(Handle child) -> Handle {
+			return Has<ChildOf>(child) ? Get<ChildOf>(child).m_parent : Handle{};
+		}
+
+		/// @brief The children of an entity, see GetChildren(). In parallel mode this is a copy, since other threads 
+		/// can change the relationships as soon as the lock of the children index is released.
+		using Children_t = std::conditional_t<LOCKGUARDTYPE == LOCKGUARDTYPE_PARALLEL, std::vector<Handle>, std::span<const Handle>>;
+
+		/// @brief Get the children of an entity, see SetParent(). Costs O(1) in sequential mode, and O(number of children)
+		/// in parallel mode, where the children are copied while the children index is locked.
+		/// @param parent The handle of the entity.
+		/// @return The children in the order they were added. In sequential mode this is a span, which is invalidated 
+		/// by changing relationships.
+		[[nodiscard]] auto GetChildren(Handle parent) -> Children_t {
+			if( !m_children ) { return {}; }
+			LockGuardShared<LOCKGUARDTYPE> lock(&m_children->GetMutex());
+			auto children = m_children->Children(parent);
+			return Children_t{ children.begin(), children.end() };
+		}
+
+		/// @brief Compute the world component W of all entities having L and W from the world component of their parent 
+		/// and their local component L, e.g. world transforms from local transforms. Entities are kept in depth levels,
+		/// see Hierarchy, and each level is processed in parallel. Only entities whose L or parent changed since the
+		/// last call, and their descendants, are computed. W is written directly, without notifying indexes on W. 
+		/// No other thread may change the registry while propagating.
+		/// @tparam L The type of the local component.
+		/// @tparam W The type of the world component.
+		/// @param combine Function computing W from a const W* pointing to the world value of the parent, or nullptr
+		/// for roots, and the local value.
+		/// @return The number of computed entities.
+		template<typename L, typename W>
+		auto Propagate(auto&& combine) -> size_t {
+			auto hierarchy = GetHierarchy<L, W>();
+			auto& levels = hierarchy->Levels();
+			if( hierarchy->NeedsRebuild(GetChildrenIndex()->Version()) ) { RebuildHierarchy<L, W>(hierarchy); }
+
+			for( auto& entry : m_archetypes ) { //writes must not clone segments shared with snapshots
+				if( entry.m_arch->Has(Type<L>()) && entry.m_arch->Has(Type<W>()) ) { entry.m_arch->template Map<W>()->unshare(); }
+			}
+
+			std::atomic<size_t> computed{0};
+			const size_t chunk = 1 << 10;
+			for( size_t d = 0; d < levels.size(); ++d ) {
+				auto& level = levels[d];
+				auto parent = d > 0 ? &levels[d - 1] : nullptr;
+				ParallelFor( (level.m_handles.size() + chunk - 1) / chunk, [&](size_t c) {
+					size_t n = 0;
+					for( size_t i = c * chunk; i < std::min((c + 1) * chunk, level.m_handles.size()); ++i ) {
+						if( parent && parent->m_dirty[level.m_parents[i]] ) { level.m_dirty[i] = 1; }
+						if( !level.m_dirty[i] ) { continue; }
+						auto& archAndIndex = ReadSlot(level.m_handles[i]).m_value;
+						auto arch = archAndIndex.m_arch;
+						W world = combine( parent ? &parent->m_world[level.m_parents[i]] : nullptr, arch->template Read<L>(archAndIndex.m_index) );
+						(*arch->template Map<W>())[archAndIndex.m_index] = world;
+						level.m_world[i] = std::move(world);
+						++n;
+					}
+					computed += n;
+				});
+			}
+			for( auto& level : levels ) { std::ranges::fill(level.m_dirty, 0); }
+			return computed;
+		}
+
+		/// @brief Get the event channel for events of type E, create it if it does not exist yet. Keep the reference 
+		/// to emit many events without looking up the channel.
+		/// @tparam E The type of the events.
+		/// @return Reference to the channel.
+		template<typename E>
+		auto GetChannel() -> EventChannel<E>& {
+			{
+				LockGuardShared<LOCKGUARDTYPE> lock(&m_channelsMutex);
+				auto it = m_channels.find(Type<E>());
+				if( it != m_channels.end() ) { return *static_cast<EventChannel<E>*>(it->second.get()); }
+			}
+			LockGuard<LOCKGUARDTYPE> lock(&m_channelsMutex);
+			auto& channel = m_channels[Type<E>()];
+			if( !channel ) { channel = std::make_unique<EventChannel<E>>(); }
+			return *static_cast<EventChannel<E>*>(channel.get());
+		}
+
+		/// @brief Send an event, see EventChannel. Can be called by many threads at the same time.
+		/// @param event The event.
+		template<typename E>
+		void Emit(E&& event) {
+			GetChannel<std::decay_t<E>>().Emit(std::forward<E>(event));
+		}
+
+		/// @brief Get the events of type E made readable by the last FlushEvents().
+		/// @tparam E The type of the events.
+		/// @return The events, contiguous in memory.
+		template<typename E>
+		[[nodiscard]] auto GetEvents() -> std::span<const E> {
+			return GetChannel<E>().Read();
+		}
+
+		/// @brief Flush all event channels, making the events emitted since the last flush readable, see EventChannel.
+		/// Call this at the end of a frame, when no thread is emitting.
+		void FlushEvents() {
+			for( auto& [type, channel] : m_channels ) { channel->Flush(); }
+		}
+
+		/// @brief Erase an entity after a number of calls to Tick(). If the entity is erased before, nothing happens.
+		/// @param handle The handle of the entity.
+		/// @param ticks The number of ticks, at least 1.
+		void EraseAfter(Handle handle, size_t ticks) {
+			LockGuard<LOCKGUARDTYPE> lock(&m_timersMutex);
+			m_timers.Schedule(ticks, Timer{handle, 0});
+		}
+
+		/// @brief Erase a component from an entity after a number of calls to Tick(). If the entity or the component
+		/// is erased before, nothing happens.
+		/// @tparam T The type of the component.
+		/// @param handle The handle of the entity.
+		/// @param ticks The number of ticks, at least 1.
+		template<typename T>
+		void RemoveComponentAfter(Handle handle, size_t ticks) {
+			LockGuard<LOCKGUARDTYPE> lock(&m_timersMutex);
+			m_timers.Schedule(ticks, Timer{handle, Type<T>()});
+		}
+
+		/// @brief Advance the registry by one tick, and erase all entities and components that are due, 
+		/// see EraseAfter() and RemoveComponentAfter(). Costs O(number of due erasures), not O(number of entities).
+		/// @return The number of due erasures, including those of entities that no longer exist.
+		auto Tick() -> size_t {
+			LockGuard<LOCKGUARDTYPE> lock(&m_timersMutex);
+			return m_timers.Advance( [&](const Timer& timer) {
+				if( !Exists(timer.m_handle) ) { return; }
+				if( timer.m_type == 0 ) { Erase(timer.m_handle); return; }
+				auto& archAndIndex = GetArchetypeAndIndex(timer.m_handle);
+				auto arch = archAndIndex.m_arch;
+				if( arch->Has(timer.m_type) ) { Move(GetArchetype(arch, {}, std::vector<size_t>{timer.m_type}), arch, archAndIndex); }
+			});
+		}
+
+		/// @brief Set the number of ticks kept in the history, see SaveTick(). Clears the history. The history is 
+		/// empty by default, so registries without rollback do not keep snapshots alive.
+		/// @param size The number of ticks, 0 turns the history off.
+		void SetHistorySize(size_t size) {
+			m_history.clear();
+			m_history.resize(size);
+			m_historyNext = 0;
+		}
+
+		/// @brief Save the current state of the registry for a tick in the history ring buffer, replacing the oldest tick.
+		/// The state is a snapshot, see Snapshot(). Segments that have not been written to since the last tick are 
+		/// shared with it, so each tick stores only the segments that were modified. The scheduled erasures of 
+		/// EraseAfter() and RemoveComponentAfter() are copied.
+		/// The history must have been turned on by SetHistorySize() before.
+		/// @param tick The number of the tick.
+		void SaveTick(size_t tick) {
+			assert( !m_history.empty() && "Call SetHistorySize() before saving ticks!" );
+			if( m_history.empty() ) { return; }
+			auto it = std::ranges::find_if(m_history, [&](auto& entry){ return entry.m_snapshot && entry.m_tick == tick; });
+			auto& entry = it != m_history.end() ? *it : m_history[m_historyNext++ % m_history.size()];
+			LockGuard<LOCKGUARDTYPE> lock(&m_timersMutex);
+			entry = { tick, std::make_unique<SnapshotView>(*this), m_timers };
+		}
+
+		/// @brief Rewind the registry to a tick saved by SaveTick(). Restores all component segments and slot maps 
+		/// including the slot versions. Entities created after the tick do not exist anymore, but since their slots get 
+		/// their versions of the tick back, their handles alias entities created in these slots after the rewind. 
+		/// Keep no such handles outside of the registry across a rewind. The scheduled 
+		/// erasures are restored as well, so erasures scheduled after the tick are dropped, and erasures that were due 
+		/// after the tick are scheduled again. Ticks saved after this tick are removed from the history. 
+		/// Do not call this while iterating over the registry.
+		/// @param tick The number of the tick.
+		/// @return true if the tick was found in the history, else false.
+		bool Rewind(size_t tick) {
+			auto it = std::ranges::find_if(m_history, [&](auto& entry){ return entry.m_snapshot && entry.m_tick == tick; });
+			if( it == m_history.end() ) { return false; }
+			auto& snapshot = *it->m_snapshot;
+			for( auto& entry : m_archetypes ) {
+				auto arch = entry.m_arch.get();
+				SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+				auto found = snapshot.m_remap.find(arch);
+				if( found != snapshot.m_remap.end() ) { arch->Restore(*found->second); } 
+				else { arch->Clear(); } //archetype was created after the tick
+			}
+			for( size_t i = 0; i < m_slotMaps.size(); ++i ) { m_slotMaps[i].m_slotMap.Restore(snapshot.m_slotMaps[i]); }
+			m_size.Reset();
+			m_size.Add(snapshot.m_size);
+			{
+				LockGuard<LOCKGUARDTYPE> lock(&m_timersMutex);
+				m_timers = it->m_timers;
+			}
+			for( auto& entry : m_history ) { if( entry.m_snapshot && entry.m_tick > tick ) { entry.m_snapshot.reset(); } }
+			for( auto& index : m_indexes ) { Rebuild(index.get()); }
+			return true;
 		}
 
 		/// @brief Get a view of entities with specific components.
@@ -475,9 +1393,9 @@ namespace vecs {
 		void Print() {
 			std::cout << "-----------------------------------------------------------------------------------------------" << std::endl;
 			std::cout << "Entities: " << Size() << std::endl;
-			for( auto& it : m_archetypes ) {
-				std::cout << "Archetype Hash: " << it.first << std::endl;
-				it.second->Print();
+			for( auto& entry : m_archetypes ) {
+				std::cout << "Archetype Hash: " << entry.m_hash << std::endl;
+				entry.m_arch->Print();
 			}
 			std::cout << std::endl << std::endl;
 		}
@@ -485,9 +1403,8 @@ namespace vecs {
 		/// @brief Validate the registry.
 		/// Make sure all archetypes have the same size in all component maps.
 		void Validate() {
-			for( auto& it : m_archetypes ) { 
-				auto arch = it.second.get();
-				arch->Validate();
+			for( auto& entry : m_archetypes ) { 
+				entry.m_arch->Validate();
 			}
 		}
 
@@ -511,21 +1428,279 @@ namespace vecs {
 			return true;
 		}
 
+		/// @brief In parallel mode, segments of read mostly components and slot maps are not freed while optimistic 
+		/// readers might still read them, see is_read_mostly. Free them. Call this regularly when no thread reads or
+		/// writes the registry, e.g. at frame end.
+		void Reclaim() {
+			for( auto& entry : m_archetypes ) { entry.m_arch->Reclaim(); }
+			for( auto& slotmap : m_slotMaps ) { slotmap.m_slotMap.Reclaim(); }
+		}
+
+		/// @brief Swap the current and previous buffers of all double buffered components, see DoubleBuffered<T>.
+		/// Call this at frame end. Costs O(1) per double buffered column.
+		void SwapBuffers() {
+			for( auto& entry : m_archetypes ) { 
+				SeqLockGuard<LOCKGUARDTYPE> guard(&entry.m_arch->GetSeqLock());
+				entry.m_arch->SwapBuffers(); 
+			}
+		}
+
+		/// @brief Get an archetype list for a view from the pool of the current thread. 
+		/// Lists keep their capacity, so views do not allocate in steady state.
+		/// @return An empty archetype list.
+		static auto AcquireViewVector() -> std::vector<ArchetypeAndSize> {
+			if( m_viewVectors.empty() ) { return {}; }
+			auto vec = std::move(m_viewVectors.back());
+			m_viewVectors.pop_back();
+			return vec;
+		}
+
+		/// @brief Return an archetype list of a view to the pool of the current thread.
+		/// @param vec The archetype list.
+		static void ReleaseViewVector(std::vector<ArchetypeAndSize>&& vec) {
+			vec.clear();
+			m_viewVectors.push_back(std::move(vec));
+		}
+
 		/// @brief Fill gaps from previous erasures.
 		// This is necessary when an entity is erased during iteration. The last entity is moved to the erased one
-		// after Iteration is finished. This is triggered by the iterator.
+		// after Iteration is finished. This is triggered by the iterator. If compaction is deferred, the gaps
+		// are left for Maintain().
 		void FillGaps(Archetype* arch) {
-			std::sort(arch->m_gaps.begin(), arch->m_gaps.end(), std::greater<size_t>());
-			Archetype::m_iteratingArchetype = nullptr;
-			for( auto& gap : arch->m_gaps ) {
-				if(gap < arch->Number()) ReindexMovedEntity(arch->Erase(gap), gap);
+			if( !arch->HasGaps() || m_deferCompaction ) { return; }
+			SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+			while( arch->HasGaps() ) {
+				auto [gap, movedHandle] = arch->FillGap();
+				ReindexMovedEntity(movedHandle, gap);
 			}
-			arch->m_gaps.clear();
-			Archetype::m_iteratingArchetype = arch;
+		}
+
+		/// @brief Defer the compaction of archetypes. Then erasing an entity only invalidates its row, leaving a gap that 
+		/// iterators skip. Gaps are filled by Maintain(), which can spread the work over several frames.
+		/// @param defer If true, compaction is deferred.
+		void SetDeferredCompaction(bool defer) {
+			m_deferCompaction = defer;
+			for( auto& entry : m_archetypes ) { entry.m_arch->SetDeferCompaction(defer); }
+		}
+
+		/// @brief Fill gaps of erased entities incrementally, archetypes with the most gaps first. 
+		/// Archetypes that are currently iterated by this thread are skipped. 
+		/// @param budget Maximum number of gaps to fill.
+		/// @return The number of gaps left.
+		size_t Maintain(size_t budget) {
+			return Maintain2( [&](size_t work){ return work < budget; } );
+		}
+
+		/// @brief Fill gaps of erased entities incrementally within a time budget, see Maintain(size_t).
+		/// @param budget Maximum time to spend. The clock is checked every 64 filled gaps.
+		/// @return The number of gaps left.
+		template<typename Rep, typename Period>
+		size_t Maintain(std::chrono::duration<Rep, Period> budget) {
+			auto end = std::chrono::steady_clock::now() + budget;
+			return Maintain2( [&](size_t work){ return (work & 63) != 0 || std::chrono::steady_clock::now() < end; } );
 		}
 
 	private:
 
+		/// @brief Add an index and fill it with the entities of all matching archetypes.
+		/// @param index The index.
+		/// @param indexes Map of indexes of this kind by component type, the index is added to it.
+		/// @return Reference to the index.
+		template<typename I>
+		auto AddIndex(std::unique_ptr<I>&& index, std::unordered_map<size_t, IndexBase*>& indexes) -> I& {
+			auto& ref = *index;
+			Rebuild(index.get());
+			indexes[Type<typename I::value_t>()] = index.get();
+			m_indexes.push_back(std::move(index));
+			return ref;
+		}
+
+		/// @brief Get the hash index of a component type.
+		/// @tparam T The type of the component, must be indexed.
+		/// @return Pointer to the index.
+		template<typename T>
+		auto GetHashIndex() -> HashIndex<T>* {
+			auto it = m_hashIndexes.find(Type<T>());
+			assert( it != m_hashIndexes.end() ); //call CreateIndex<T>() first
+			return static_cast<HashIndex<T>*>(it->second);
+		}
+
+		/// @brief Get the spatial index of a component type.
+		/// @tparam P The type of the position component, must have a spatial index.
+		/// @return Pointer to the index.
+		template<typename P>
+		auto GetSpatialIndex() -> SpatialIndex<P>* {
+			auto it = m_spatialIndexes.find(Type<P>());
+			assert( it != m_spatialIndexes.end() ); //call CreateSpatialIndex<P>() first
+			return static_cast<SpatialIndex<P>*>(it->second);
+		}
+
+		/// @brief Get the children index, create it if it does not exist yet.
+		/// @return Pointer to the index.
+		auto GetChildrenIndex() -> ChildrenIndex* {
+			if( !m_children ) {
+				auto children = std::make_unique<ChildrenIndex>();
+				m_children = children.get();
+				Rebuild(m_children);
+				m_indexes.push_back(std::move(children));
+			}
+			return m_children;
+		}
+
+		/// @brief Get the hierarchy of a pair of local and world components, create it if it does not exist yet.
+		/// @tparam L The type of the local component.
+		/// @tparam W The type of the world component.
+		/// @return Pointer to the hierarchy.
+		template<typename L, typename W>
+		auto GetHierarchy() -> Hierarchy<L, W>* {
+			auto& hierarchy = m_hierarchies[{Type<L>(), Type<W>()}];
+			if( !hierarchy ) {
+				auto index = std::make_unique<Hierarchy<L, W>>();
+				hierarchy = index.get();
+				Rebuild(hierarchy);
+				m_indexes.push_back(std::move(index));
+			}
+			return static_cast<Hierarchy<L, W>*>(hierarchy);
+		}
+
+		/// @brief Sort all entities having L and W into depth levels. Roots are entities without a parent having L and W.
+		/// @tparam L The type of the local component.
+		/// @tparam W The type of the world component.
+		/// @param hierarchy The hierarchy.
+		template<typename L, typename W>
+		void RebuildHierarchy(Hierarchy<L, W>* hierarchy) {
+			auto children = GetChildrenIndex();
+			hierarchy->BeginRebuild(children->Version());
+			for( auto& entry : m_archetypes ) {
+				auto arch = entry.m_arch.get();
+				if( !hierarchy->Matches(arch) ) { continue; }
+				for( size_t i = 0; i < arch->Number(); ++i ) {
+					auto handle = arch->template Read<Handle>(i);
+					if( !handle.IsValid() ) { continue; } //skip gaps
+					if( arch->Has(Type<ChildOf>()) ) {
+						auto parent = arch->template Read<ChildOf>(i).m_parent;
+						if( Exists(parent) && hierarchy->Matches(GetSlot(parent).m_value.m_arch) ) { continue; }
+					}
+					hierarchy->Push(handle, 0, 0);
+				}
+			}
+			auto& levels = hierarchy->Levels();
+			for( size_t d = 0; d < levels.size(); ++d ) { //breadth first, levels[d] grows while being read
+				for( size_t i = 0; i < levels[d].m_handles.size(); ++i ) {
+					for( auto child : children->Children(levels[d].m_handles[i]) ) {
+						if( hierarchy->Matches(GetSlot(child).m_value.m_arch) ) { hierarchy->Push(child, d + 1, (uint32_t)i); }
+					}
+				}
+			}
+		}
+
+		/// @brief Erase or orphan the children of an entity that is about to be erased, see SetParent().
+		/// @param handle The handle of the entity.
+		void EraseChildren(Handle handle) {
+			auto span = m_children->Children(handle);
+			if( span.empty() ) { return; }
+			std::vector<Handle> children{span.begin(), span.end()}; //erasing changes the span
+			for( auto child : children ) {
+				if( Get<ChildOf>(child).m_cascade ) { Erase(child); }
+				else { Erase<ChildOf>(child); }
+			}
+		}
+
+		/// @brief Clear an index and add all entities of all matching archetypes.
+		/// @param index The index.
+		void Rebuild(IndexBase* index) {
+			LockGuard<LOCKGUARDTYPE> lock(&index->GetMutex());
+			index->Clear();
+			for( auto& entry : m_archetypes ) {
+				auto arch = entry.m_arch.get();
+				if( !index->Matches(arch) ) { continue; }
+				for( size_t i = 0; i < arch->Number(); ++i ) {
+					auto handle = arch->template Read<Handle>(i);
+					if( handle.IsValid() ) { index->Add(handle, arch, i); } //skip gaps
+				}
+			}
+		}
+
+		/// @brief Tell all matching indexes that an entity was added to an archetype.
+		/// @param handle The handle of the entity.
+		/// @param arch The archetype.
+		/// @param index The index of the entity in the archetype.
+		void Added(Handle handle, Archetype* arch, size_t index) {
+			for( auto& idx : m_indexes ) {
+				if( !idx->Matches(arch) ) { continue; }
+				LockGuard<LOCKGUARDTYPE> lock(&idx->GetMutex());
+				idx->Add(handle, arch, index);
+			}
+		}
+
+		/// @brief Tell all matching indexes that an entity is about to be removed from an archetype.
+		/// @param handle The handle of the entity.
+		/// @param arch The archetype.
+		/// @param index The index of the entity in the archetype.
+		void Removed(Handle handle, Archetype* arch, size_t index) {
+			for( auto& idx : m_indexes ) {
+				if( !idx->Matches(arch) ) { continue; }
+				LockGuard<LOCKGUARDTYPE> lock(&idx->GetMutex());
+				idx->Remove(handle, arch, index);
+			}
+		}
+
+		/// @brief Write components of an entity. Indexes that depend on the components remove the entity before 
+		/// and add it again after the write.
+		/// @tparam Ts The types of the written components.
+		/// @param handle The handle of the entity.
+		/// @param arch The archetype of the entity.
+		/// @param index The index of the entity in the archetype.
+		/// @param write Function doing the write.
+		template<typename... Ts>
+		void Write(Handle handle, Archetype* arch, size_t index, auto&& write) {
+			auto affected = [&](auto& idx) { return (idx->DependsOn(Type<Ts>()) || ...) && idx->Matches(arch); };
+			for( auto& idx : m_indexes ) { 
+				if( affected(idx) ) { LockGuard<LOCKGUARDTYPE> lock(&idx->GetMutex()); idx->Remove(handle, arch, index); } 
+			}
+			write();
+			for( auto& idx : m_indexes ) { 
+				if( affected(idx) ) { LockGuard<LOCKGUARDTYPE> lock(&idx->GetMutex()); idx->Add(handle, arch, index); } 
+			}
+		}
+
+		/// @brief Test if an entity can be added to an archetype without exceeding its fixed capacity.
+		/// If the archetype is full but has gaps, one gap is filled to make room.
+		/// @param arch The archetype.
+		/// @return true if there is room for an entity.
+		bool HasRoom(Archetype* arch) {
+			if( !arch->Full() ) { return true; }
+			if( !arch->HasGaps() || arch == Archetype::m_iteratingArchetype ) { return false; }
+			SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+			auto [gap, movedHandle] = arch->FillGap();
+			ReindexMovedEntity(movedHandle, gap);
+			return true;
+		}
+
+		/// @brief Fill gaps while there is budget left, archetypes with the most gaps first.
+		/// @param hasBudget Called with the number of gaps filled so far, returns true if more can be filled.
+		/// @return The number of gaps left.
+		size_t Maintain2(auto&& hasBudget) {
+			size_t work = 0;
+			while( true ) {
+				Archetype* arch = nullptr;
+				for( auto& entry : m_archetypes ) {
+					auto a = entry.m_arch.get();
+					if( a != Archetype::m_iteratingArchetype && a->Gaps() > (arch ? arch->Gaps() : 0) ) { arch = a; }
+				}
+				if( arch == nullptr || !hasBudget(work) ) { break; }
+				SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+				while( arch->HasGaps() && hasBudget(work) ) {
+					auto [gap, movedHandle] = arch->FillGap();
+					ReindexMovedEntity(movedHandle, gap);
+					++work;
+				}
+			}
+			size_t gaps = 0;
+			for( auto& entry : m_archetypes ) { gaps += entry.m_arch->Gaps(); }
+			return gaps;
+		}
+
 		/// @brief Test if a type is in a container.
 		/// @param container The container to search.
 		/// @param hs The type hash to search for.
@@ -548,6 +1723,14 @@ namespace vecs {
 			return m_slotMaps[handle.GetStorageIndex()].m_slotMap[handle];
 		}
 
+		/// @brief Get the slot of an entity for reading. Unlike GetSlot(), this never clones a segment shared with a 
+		/// snapshot, so several threads can call it at the same time.
+		/// @param handle The handle of the entity.
+		/// @return Reference to the slot.
+		auto ReadSlot( Handle handle ) -> const Slot_t& {
+			return std::as_const(m_slotMaps[handle.GetStorageIndex()].m_slotMap)[handle];
+		}
+
 		/// @brief Get the index of the entity in the archetype
 		/// @param handle The handle of the entity.
 		/// @return The index of the entity and the archetype.
@@ -555,6 +1738,41 @@ namespace vecs {
 			return GetSlot(handle).m_value;
 		}
 
+		/// @brief An entity of a batched access, see Gather().
+		struct GatherEntry {
+			Archetype* m_arch;	//archetype of the entity
+			size_t m_index;		//index of the entity in the archetype
+			size_t m_pos;		//position of the handle in the batch
+		};
+
+		static const size_t PREFETCH_DISTANCE = 8; //number of entities that batched accesses prefetch ahead
+
+		/// @brief Look up the slots of many entities, and sort the existing entities by archetype and index. 
+		/// Slot loads are pipelined, the slot of the entity PREFETCH_DISTANCE ahead is prefetched.
+		/// @param handles The handles of the entities.
+		/// @return The scratch list of the current thread, overwritten by the next call.
+		auto Gather(std::span<const Handle> handles) -> std::vector<GatherEntry>& {
+			auto& gather = m_gather;
+			gather.clear();
+			for( size_t i = 0; i < handles.size(); ++i ) {
+				if( i + PREFETCH_DISTANCE < handles.size() ) {
+					auto ahead = handles[i + PREFETCH_DISTANCE];
+					if( ahead.GetStorageIndex() < m_slotMaps.size() ) {
+						VECS_PREFETCH(m_slotMaps[ahead.GetStorageIndex()].m_slotMap.address(ahead));
+					}
+				}
+				auto handle = handles[i];
+				if( !handle.IsValid() || handle.GetStorageIndex() >= m_slotMaps.size() || !Exists(handle) ) { continue; }
+				auto& value = ReadSlot(handle).m_value;
+				gather.push_back( { value.m_arch, value.m_index, i } );
+			}
+			std::ranges::sort(gather, [](const GatherEntry& a, const GatherEntry& b) {
+				if( a.m_arch != b.m_arch ) { return std::less<Archetype*>{}(a.m_arch, b.m_arch); }
+				return a.m_index != b.m_index ? a.m_index < b.m_index : a.m_pos < b.m_pos; //keep the batch order of duplicates
+			});
+			return gather;
+		}
+
 		/// @brief Get a new index of the slotmap for the current thread.
 		/// @return New index of the slotmap.
 		size_t GetNewSlotmapIndex() {
@@ -562,13 +1780,15 @@ namespace vecs {
 			return m_slotMapIndex;
 		}
 		
-		/// @brief Create a list of type hashes
+		/// @brief Create a list of type hashes. The list is a scratch vector of the current thread, so creating 
+		/// it does not allocate in steady state. It is overwritten by the next call.
 		/// @param arch The archetype types to use
 		/// @param tags Use also these tag hashes
 		/// @return A vector of type hashes
 		template<typename... Ts>
-		auto CreateTypeList(Archetype* arch, const std::vector<size_t>&& tags, const std::vector<size_t>&& ignore) -> std::vector<size_t> {
-			std::vector<size_t> all{ tags.begin(), tags.end() };
+		auto CreateTypeList(Archetype* arch, const std::vector<size_t>&& tags, const std::vector<size_t>&& ignore) -> std::vector<size_t>& {
+			auto& all = m_typeList;
+			all.assign( tags.begin(), tags.end() );
 			(AddType(all, Type<Ts>()), ...);
 			if(arch) { for( auto type : arch->Types() ) { if(!ContainsType(ignore, type)) { AddType(all, type); } } }
 			return all;
@@ -578,11 +1798,13 @@ namespace vecs {
 		/// @tparam ...Ts The component types.
 		/// @param arch Use the types of this archetype.
 		/// @param tags Should have the tags of the entity.
-		/// @return A pointer to the archetype.
+		/// @return A pointer to the archetype, or nullptr if the maximum number of archetypes would be exceeded.
 		template<typename... Ts>
 		auto GetArchetype(Archetype* arch, const std::vector<size_t>&& tags, const std::vector<size_t>&& ignore) -> Archetype* {
-			size_t hs = Hash(CreateTypeList<Ts...>(arch, std::forward<decltype(tags)>(tags), std::forward<decltype(ignore)>(ignore)));
-			if( m_archetypes.contains( hs ) ) { return m_archetypes[hs].get(); }
+			auto& types = CreateTypeList<Ts...>(arch, std::forward<decltype(tags)>(tags), std::forward<decltype(ignore)>(ignore));
+			size_t hs = Hash(types); //also sorts the types, so the signature is unique
+			if( auto found = m_archetypes.Find(hs, types) ) { return found; }
+			if( m_maxArchetypes > 0 && m_archetypes.size() >= m_maxArchetypes ) { return nullptr; }
 
 			auto newArchUnique = std::make_unique<Archetype>();
 			auto newArch = newArchUnique.get();
@@ -590,10 +1812,14 @@ namespace vecs {
 			auto fun = [&]<typename T>(){ if( !ContainsType(newArch->Types(), Type<T>()) ) { newArch->template AddComponent<T>(); } };
 			(fun.template operator()<Ts>(), ...);
 			for( auto tag : tags ) { 
-				if(!ContainsType(newArch->Types(), tag) && !ContainsType(ignore, tag)) { newArch->AddType(tag); } 
+				if( ContainsType(newArch->Types(), tag) || ContainsType(ignore, tag) ) { continue; }
+				if( auto it = m_components.find(tag); it != m_components.end() ) { //runtime component
+					newArch->AddColumn(tag, std::make_unique<RawVector>(it->second));
+				} else { newArch->AddType(tag); }
 			} //add new tags
-			m_archetypes[hs] = std::move(newArchUnique); //store the archetype
-			return newArch;
+			if( m_maxEntities > 0 ) { newArch->Reserve(m_maxEntities); }
+			newArch->SetDeferCompaction(m_deferCompaction);
+			return m_archetypes.Insert(hs, std::vector<size_t>{types}, std::move(newArchUnique)); //store the archetype
 		}
 
 		/// @brief If a entity is moved or erased, the last entity of the archetype is moved to the empty slot.
@@ -603,17 +1829,83 @@ namespace vecs {
 		void ReindexMovedEntity(Handle handle, size_t index) {
 			if( !handle.IsValid() ) { return; }
 			auto& archAndIndex = GetArchetypeAndIndex(handle);
-			archAndIndex.m_index = index;
+			StoreRelease(archAndIndex.m_index, index);
 		}
 
 		/// @brief Move an entity to a new archetype.
 		/// @param newArch The new archetype.
 		/// @param oldArch The old archetype.
 		/// @param archAndIndex The archetype and index of the entity.
-		void Move(Archetype* newArch, Archetype* oldArch, vecs::Archetype::ArchetypeAndIndex& archAndIndex) {
-			auto [newIndex, movedHandle] = newArch->Move(*oldArch, archAndIndex.m_index);
-			ReindexMovedEntity(movedHandle, archAndIndex.m_index);
-			archAndIndex = { newArch, newIndex };
+		/// @param vs Values of components of the new archetype, constructed in place instead of being copied.
+		/// @return false if the new archetype could not be created or is full, see Registry::Registry().
+		template<typename... Ts>
+		bool Move(Archetype* newArch, Archetype* oldArch, vecs::Archetype::ArchetypeAndIndex& archAndIndex, Ts&&... vs) {
+			if( newArch == nullptr || (newArch != oldArch && !HasRoom(newArch)) ) { return false; }
+			Handle handle = m_indexes.empty() ? Handle{} : oldArch->template Read<Handle>(archAndIndex.m_index);
+			if( !m_indexes.empty() ) { Removed(handle, oldArch, archAndIndex.m_index); }
+			{
+				SeqLockGuard<LOCKGUARDTYPE> guardOld(&oldArch->GetSeqLock()); //the slot update is part of the write
+				SeqLockGuard<LOCKGUARDTYPE> guardNew(newArch != oldArch ? &newArch->GetSeqLock() : nullptr);
+				auto [newIndex, movedHandle] = newArch->Move(*oldArch, archAndIndex.m_index, std::forward<Ts>(vs)...);
+				ReindexMovedEntity(movedHandle, archAndIndex.m_index);
+				StoreRelease(archAndIndex.m_index, newIndex); //optimistic readers load the archetype first
+				StoreRelease(archAndIndex.m_arch, newArch);
+			}
+			if( !m_indexes.empty() ) { Added(handle, newArch, archAndIndex.m_index); }
+			return true;
+		}
+
+		/// @brief Apply the changes collected by a builder, see Builder.
+		/// @param handle The entity, or an invalid handle to create a new entity.
+		/// @param tags Tags to add.
+		/// @param erase Components and tags to erase.
+		/// @param vs Component values to put.
+		/// @return The handle of the entity, or an invalid handle on failure.
+		template<typename... Ts>
+		auto Commit(Handle handle, std::vector<size_t>&& tags, std::vector<size_t>&& erase, Ts&&... vs) -> Handle {
+			if( !handle.IsValid() ) { 
+				if constexpr (sizeof...(Ts) == 0) { return {}; } //an entity needs a component
+				else return Insert2( std::move(tags), std::forward<Ts>(vs)... ); 
+			}
+			if( !Exists(handle) ) { return {}; }
+			auto& archAndIndex = GetArchetypeAndIndex(handle);
+			auto arch = archAndIndex.m_arch;
+			auto newArch = GetArchetype<Ts...>(arch, std::move(tags), std::move(erase)); //the only lookup
+			if( newArch == arch ) { //only overwrites existing components
+				if constexpr (sizeof...(Ts) > 0) {
+					Write<std::decay_t<Ts>...>(handle, arch, archAndIndex.m_index, [&]() {
+						SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+						arch->Put(archAndIndex.m_index, std::forward<Ts>(vs)...);
+					});
+				}
+				return handle;
+			}
+			return Move(newArch, arch, archAndIndex, std::forward<Ts>(vs)...) ? handle : Handle{}; //the only move
+		}
+
+		/// @brief Create an entity with components and tags.
+		/// @param tags The tags of the entity.
+		/// @param ...component The new values.
+		/// @return Handle of new entity, or an invalid handle if the fixed capacity would be exceeded.
+		template<typename... Ts>
+		auto Insert2( std::vector<size_t>&& tags, Ts&&... component ) -> Handle {
+			auto arch = GetArchetype<Ts...>(nullptr, std::move(tags), {});
+			if( arch == nullptr || !HasRoom(arch) ) { return {}; } //fixed capacity exceeded
+			size_t slotMapIndex = GetNewSlotmapIndex();
+			if( m_maxEntities > 0 ) { //fixed capacity, find a slot map with a free slot
+				if( Size() >= m_maxEntities ) { return {}; }
+				for( size_t i = 1; m_slotMaps[slotMapIndex].m_slotMap.Full(); ++i ) {
+					if( i == NUMBER_SLOTMAPS::value ) { return {}; }
+					slotMapIndex = GetNewSlotmapIndex();
+				}
+			}
+			auto [handle, slot] = m_slotMaps[slotMapIndex].m_slotMap.Insert( {nullptr, 0} ); //get a slot for the entity
+			SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+			StoreRelease(slot.m_value.m_index, arch->Insert( handle, std::forward<Ts>(component)... )); //insert the entity into the archetype
+			StoreRelease(slot.m_value.m_arch, arch);
+			Added(handle, arch, slot.m_value.m_index);
+			m_size.Add(1);
+			return handle;
 		}
 
 		/// @brief Get component values of an entity.
@@ -623,46 +1915,118 @@ namespace vecs {
 		template<typename... Ts>
 			requires (vtll::unique<vtll::tl<Ts...>>::value && !vtll::has_type< vtll::tl<Ts...>, Handle&>::value)
 		[[nodiscard]] auto Get2(Handle handle) {
+			if constexpr (OPTIMISTIC<Ts...>) {
+				if( auto values = GetOptimistic<Ts...>(handle) ) { return *values; }
+			}
 			auto& slot = GetSlot(handle);
 			auto& archAndIndex = slot.m_value; //  GetArchetypeAndIndex(handle);
 			auto arch = archAndIndex.m_arch;
 			if( (arch->Has(Type<Ts>()) && ...) ) { return std::tuple<to_ref_t<Ts>...>{ Get3<Ts>(handle, slot)... }; } 
 			auto newArch = GetArchetype<Ts...>(arch, {}, {});
-			Move(newArch, arch, archAndIndex);
+			if( !Move(newArch, arch, archAndIndex) ) {
+				std::cout << "Get() cannot add components to an entity because the fixed capacity would be exceeded!" << std::endl;
+				assert(false);
+				exit(-1);
+			}
 			return std::tuple<to_ref_t<Ts>...>{ Get3<Ts>(handle, slot)... }; 
 		}
 
+		/// @brief Read component values optimistically without locking, see is_read_mostly.
+		/// @tparam Ts The types of the components.
+		/// The slot is found through the segment table of optimistic readers, and its fields are loaded atomically, 
+		/// so concurrent inserts that grow the slot map or the archetype never make the reader access freed memory.
+		/// @param handle The handle of the entity.
+		/// @return A tuple of the component values, or std::nullopt if the entity does not have all components.
+		template<typename... Ts>
+		auto GetOptimistic(Handle handle) -> std::optional<std::tuple<component_value_t<Ts>...>> {
+			auto& slotMap = std::as_const(m_slotMaps[handle.GetStorageIndex()].m_slotMap);
+			std::tuple<component_value_t<Ts>...> values;
+			while( true ) {
+				const Slot_t* slot = slotMap.ReadAddress(handle);
+				if( slot == nullptr || LoadAcquire(slot->m_version) != handle.GetVersion() ) { return std::nullopt; }
+				Archetype* arch = LoadAcquire(slot->m_value.m_arch);
+				if( arch == nullptr || !(arch->Has(Type<Ts>()) && ...) ) { return std::nullopt; }
+				size_t seq = arch->GetSeqLock().ReadBegin();
+				size_t index = LoadAcquire(slot->m_value.m_index);
+				if( LoadAcquire(slot->m_value.m_arch) != arch ) { continue; } //entity was moved meanwhile
+				if( !arch->template TryRead<Ts...>(index, seq, values) ) { continue; }
+				if( slotMap.ReadAddress(handle) == slot && LoadAcquire(slot->m_version) == handle.GetVersion() ) { 
+					return values; //else the slot was cloned or erased meanwhile
+				}
+			}
+		}
+
 		template<typename T>
 			requires (!std::is_reference_v<T>)
-		auto Get3(Handle handle, Slot_t& slot ) -> T { //Archetype* arch, size_t index) -> T {
-			return slot.m_value.m_arch->template Get<T>(slot.m_value.m_index);
+		auto Get3(Handle, Slot_t& slot ) -> component_value_t<T> { //Archetype* arch, size_t index) -> T {
+			return slot.m_value.m_arch->template Read<T>(slot.m_value.m_index);
 		}
 
 		template<typename T>
 		requires std::is_reference_v<T>
-		auto Get3(Handle handle, Slot_t& slot ) { //Archetype* arch, size_t index) {
-			return Ref<std::decay_t<T>>(handle, slot) ; //arch->template Get<Handle>(index), arch->template Get<std::decay_t<T>>(index));
+		auto Get3(Handle handle, Slot_t& ) { //Archetype* arch, size_t index) {
+			return Ref<std::decay_t<T>>(handle, *this) ; //arch->template Get<Handle>(index), arch->template Get<std::decay_t<T>>(index));
 		}
 
 		/// @brief Change the component values of an entity.
 		/// @tparam ...Ts The types of the components.
 		/// @param handle The handle of the entity.
 		/// @param ...vs The new values.
+		/// @return false if the registry has a fixed capacity that would be exceeded, else true.
 		template<typename... Ts>
-		void Put2(Handle handle, Ts&&... vs) {
+		bool Put2(Handle handle, Ts&&... vs) {
 			auto& archAndIndex = GetArchetypeAndIndex(handle);
 			auto arch = archAndIndex.m_arch;
-			if( (arch->Has(Type<Ts>()) && ...) ) { arch->Put(archAndIndex.m_index, std::forward<Ts>(vs)...); return; }
-			auto newArch = GetArchetype<Ts...>(arch, {}, {});
-			Move(newArch, arch, archAndIndex);
-			newArch->Put(archAndIndex.m_index, std::forward<Ts>(vs)...);
+			if( !(arch->Has(Type<Ts>()) && ...) ) {
+				auto newArch = GetArchetype<Ts...>(arch, {}, {});
+				if( !Move(newArch, arch, archAndIndex) ) { return false; }
+				arch = newArch;
+			}
+			Write<std::decay_t<Ts>...>(handle, arch, archAndIndex.m_index, [&]() {
+				SeqLockGuard<LOCKGUARDTYPE> guard(&arch->GetSeqLock());
+				arch->Put(archAndIndex.m_index, std::forward<Ts>(vs)...); 
+			});
+			return true;
 		}
 
-		Size_t m_size{0}; //number of entities
+		/// @brief An erasure scheduled by EraseAfter() or RemoveComponentAfter().
+		struct Timer {
+			Handle m_handle;	//the entity
+			size_t m_type;		//type of the component to erase, 0 to erase the entity
+		};
+
+		/// @brief A tick saved in the history, see SaveTick().
+		struct TickAndSnapshot {
+			size_t m_tick{0};							//number of the tick
+			std::unique_ptr<SnapshotView> m_snapshot;	//state of the registry, nullptr if unused
+			TimingWheel<Timer> m_timers;				//scheduled erasures
+		};
+
+		size_t m_maxEntities{0}; //maximum number of entities for fixed capacity, 0 if unlimited
+		size_t m_maxArchetypes{0}; //maximum number of archetypes for fixed capacity, 0 if unlimited
+		bool m_deferCompaction{false}; //if true, erasures leave gaps that are filled by Maintain()
+		std::vector<std::unique_ptr<IndexBase>> m_indexes; //all indexes, notified about changes
+		std::unordered_map<size_t, IndexBase*> m_hashIndexes; //hash indexes by component type
+		std::unordered_map<size_t, IndexBase*> m_orderedIndexes; //ordered indexes by component type
+		std::unordered_map<size_t, IndexBase*> m_spatialIndexes; //spatial indexes by position component type
+		std::map<std::vector<size_t>, IndexBase*> m_aggregates; //aggregates by view definition
+		ChildrenIndex* m_children{nullptr}; //children of all parents, created by the first SetParent()
+		std::map<std::pair<size_t, size_t>, IndexBase*> m_hierarchies; //hierarchies by local and world component type
+		std::unordered_map<size_t, std::unique_ptr<EventChannelBase>> m_channels; //event channels by event type
+		std::unordered_map<size_t, std::shared_ptr<const ComponentDescriptor>> m_components; //runtime components by id
+		Mutex_t m_channelsMutex; //protects the channel map
+		TimingWheel<Timer> m_timers; //scheduled erasures
+		Mutex_t m_timersMutex; //protects the timers
+		Counter_t m_size; //number of entities, per-thread accumulators
 		SlotMaps_t m_slotMaps; //Slotmap array for entities. Each slot map has its own mutex.
-		HashMap_t m_archetypes; //Mapping hash (from type hashes) to archetype 1:1. 
+		HashMap_t m_archetypes; //Mapping sorted type signature to archetype 1:1. 
 		Mutex_t m_mutex; //mutex for reading and writing m_archetypes.
+		std::vector<TickAndSnapshot> m_history; //ring buffer of saved ticks
+		size_t m_historyNext{0}; //next entry of the ring buffer to overwrite
 		inline static thread_local size_t m_slotMapIndex = NUMBER_SLOTMAPS::value - 1; //for new entities
+		inline static thread_local std::vector<size_t> m_typeList; //scratch list for GetArchetype()
+		inline static thread_local std::vector<GatherEntry> m_gather; //scratch list for batched accesses
+		inline static thread_local std::vector<std::vector<ArchetypeAndSize>> m_viewVectors; //pool of archetype lists for views
 	};
 
 	template<typename T>
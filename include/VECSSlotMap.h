@@ -20,6 +20,8 @@ namespace vecs {
 			size_t m_version;	//version of the slot
 			T 	   m_value{};	//value of the slot
 
+			static constexpr bool READ_OPTIMISTIC = true; ///< Slots are read by optimistic readers, see Vector<T>::ReadAddress().
+
 			Slot() = default;
 
 			/// @brief Constructor, creates a slot.
@@ -68,6 +70,11 @@ namespace vecs {
 			m_slots.push_back( Slot(int64_t{-1}, size_t{0}, T{}) ); //last slot
 		}
 		
+		/// @brief Move constructor, takes over the slots by sharing their segments.
+		SlotMap( SlotMap&& other ) noexcept : m_storageIndex{other.m_storageIndex}, m_size{other.m_size}, m_firstFree{other.m_firstFree} {
+			m_slots.share(other.m_slots);
+		}
+
 		~SlotMap() = default; ///< Destructor.
 		
 		/// @brief Insert a value to the slot map.
@@ -75,13 +82,13 @@ namespace vecs {
 		/// @return A pair of the handle and reference to the slot.
 		auto Insert(T& value) -> std::pair<Handle, Slot&> {
 			auto [handle, slot] = Insert2(std::forward<T>(value));
-			slot.m_value = value;
+			Assign(slot.m_value, value);
 			return {handle, slot};		
 		}
 
 		auto Insert(T&& value) -> std::pair<Handle, Slot&> {
 			auto [handle, slot] = Insert2(std::forward<T>(value));
-			slot.m_value = std::forward<T>(value);
+			Assign(slot.m_value, std::forward<T>(value));
 			return {handle, slot};				
 		}
 
@@ -89,7 +96,8 @@ namespace vecs {
 		/// @param handle The handle of the value to erase.
 		void Erase(Handle handle) {
 			auto& slot = m_slots[handle.GetIndex()];
-			++slot.m_version;	//increment the version to invalidate the slot
+			StoreRelease(slot.m_version, slot.m_version + 1);	//increment the version to invalidate the slot
+			Assign(slot.m_value, T{});
 			slot.m_nextFree = m_firstFree;	
 			m_firstFree = handle.GetIndex(); //add the slot to the free list
 			--m_size;
@@ -102,12 +110,84 @@ namespace vecs {
 			return m_slots[handle.GetIndex()];
 		}
 
+		/// @brief Get a value from the slot map for reading.
+		/// @param handle The handle of the value to get.
+		/// @return Reference to the value.
+		auto operator[](Handle handle) const -> const Slot& {
+			return m_slots[handle.GetIndex()];
+		}
+
+		/// @brief Get the address of a slot for optimistic readers, see Vector<T>::ReadAddress().
+		/// @param handle The handle of the value.
+		/// @return Pointer to the slot, or nullptr if the index is out of range.
+		auto ReadAddress(Handle handle) const -> const Slot* {
+			return m_slots.ReadAddress(handle.GetIndex());
+		}
+
+		/// @brief Get the epoch of the slots, addresses of slots stay valid while it does not change, see Vector<T>::epoch().
+		auto Epoch() const -> size_t { return m_slots.epoch(); }
+
+		/// @brief Free slot segments retired for optimistic readers, see Vector<T>::reclaim().
+		void Reclaim() {
+			m_slots.reclaim();
+		}
+
+		/// @brief Get the address of a slot for prefetching, see Vector<T>::address().
+		/// @param handle The handle of the value.
+		/// @return Pointer to the slot, or nullptr if the index is out of range.
+		auto address(Handle handle) const -> Slot* {
+			return m_slots.address(handle.GetIndex());
+		}
+
+		/// @brief Create a snapshot of the slot map. The snapshot shares the slot segments copy-on-write.
+		/// @return The snapshot.
+		auto Snapshot() const -> SlotMap {
+			SlotMap map{*this, 0};
+			map.m_slots.share(m_slots);
+			map.m_firstFree = m_firstFree;
+			map.m_size = m_size;
+			return map; //moved, see the move constructor
+		}
+
+		/// @brief Restore the slot map from a snapshot, including the slot versions and the free list. 
+		/// The slot segments are shared copy-on-write with the snapshot, so the snapshot can be restored again.
+		/// @param snapshot The snapshot to restore.
+		void Restore(const SlotMap& snapshot) {
+			assert(m_storageIndex == snapshot.m_storageIndex);
+			m_slots.share(snapshot.m_slots);
+			m_firstFree = snapshot.m_firstFree;
+			m_size = snapshot.m_size;
+		}
+
 		/// @brief Get the size of the slot map.
 		/// @return The size of the slot map.
 		auto Size() const -> size_t {
 			return m_size;
 		}
 
+		/// @brief Test if there are no free slots left. Then inserting a value allocates a new slot.
+		/// @return true if there are no free slots.
+		auto Full() const -> bool {
+			return m_firstFree < 0;
+		}
+
+		/// @brief Get the number of slots, including the free slots.
+		/// @return The number of slots.
+		auto Capacity() const -> size_t {
+			return m_slots.size();
+		}
+
+		/// @brief Compute a deterministic hash of the slot versions and the free list.
+		/// @param seed The seed.
+		/// @return The hash.
+		auto Checksum(size_t seed) const -> size_t {
+			for( size_t i = 0; i < m_slots.size(); ++i ) {
+				auto& slot = m_slots[i];
+				seed = HashCombine(seed, (slot.m_version << 1) ^ (size_t)slot.m_nextFree);
+			}
+			return HashCombine(HashCombine(seed, m_size), (size_t)m_firstFree);
+		}
+
 		/// @brief Clear the slot map. This puts all slots in the free list.
 		void Clear() {
 			m_firstFree = 0;
@@ -116,12 +196,28 @@ namespace vecs {
 			for( size_t i = 1; i <= size-1; ++i ) { 
 				m_slots[i-1].m_nextFree = i;
 				m_slots[i-1].m_version++;
+				m_slots[i-1].m_value = {};
 			}
 			m_slots[size-1].m_nextFree = -1;
 			m_slots[size-1].m_version++;
+			m_slots[size-1].m_value = {};
 		}
 
 	private:
+		/// @brief Constructor for snapshots, creates an empty slot map without slots.
+		SlotMap( const SlotMap& other, int ) : m_storageIndex{other.m_storageIndex} {}
+
+		/// @brief Assign a value to a slot. Values that optimistic readers load concurrently are stored field by field.
+		static void Assign(T& dst, T&& src) {
+			if constexpr (requires { dst.Store(src); }) { dst.Store(src); } 
+			else { dst = std::forward<T>(src); }
+		}
+
+		static void Assign(T& dst, const T& src) {
+			if constexpr (requires { dst.Store(src); }) { dst.Store(src); } 
+			else { dst = src; }
+		}
+
 		auto Insert2(const T&& value) -> std::pair<Handle, Slot&> {
 			int64_t index = m_firstFree;
 			Slot* slot = nullptr;
@@ -0,0 +1,100 @@
+#pragma once
+
+namespace vecs {
+
+	//----------------------------------------------------------------------------------------------
+	//Timing wheel
+
+	/// @brief A hierarchical timing wheel for values that become due after a number of ticks. Level l has 2^B slots,
+	/// each covering 2^(B*l) ticks. A value is put into the lowest level whose range covers its delay, and whenever 
+	/// the lower level has wrapped around, the values of the next slot of a higher level are redistributed to the 
+	/// levels below. Scheduling costs O(1), and advancing the wheel only touches the slots that are due, 
+	/// instead of scanning all scheduled values.
+	/// @tparam T The type of the scheduled values.
+	/// @tparam B Number of bits per level.
+	/// @tparam L Number of levels. Delays of 2^(B*L) ticks or more are redistributed until they fit.
+	template<typename T, size_t B = 8, size_t L = 4>
+	class TimingWheel {
+
+		static_assert(B > 0 && L > 0 && B * L < 64);
+
+		static const size_t SLOTS = 1ull << B;
+		static const size_t MASK = SLOTS - 1;
+
+		/// @brief A scheduled value.
+		struct Entry {
+			size_t m_due;	//tick when the value is due
+			T m_value;		//the value
+		};
+
+	public:
+		TimingWheel() : m_slots(L * SLOTS) {}
+
+		/// @brief Schedule a value.
+		/// @param delay The number of calls to Advance() until the value is due, at least 1.
+		/// @param value The value.
+		void Schedule(size_t delay, T value) {
+			Insert( Entry{ m_now + std::max<size_t>(delay, 1), std::move(value) } );
+			++m_size;
+		}
+
+		/// @brief Advance the wheel by one tick and hand out all values that are due.
+		/// @param fun Function called with each due value. It may schedule new values.
+		/// @return The number of due values.
+		auto Advance(auto&& fun) -> size_t {
+			++m_now;
+			for( size_t l = 1; l < L && (m_now & ((1ull << (B * l)) - 1)) == 0; ++l ) { //the level below wrapped around
+				m_scratch.swap( Slot(l, (m_now >> (B * l)) & MASK) );
+				for( auto& entry : m_scratch ) { Insert( std::move(entry) ); }
+				m_scratch.clear();
+			}
+			m_scratch.swap( Slot(0, m_now & MASK) );
+			size_t due = m_scratch.size();
+			m_size -= due;
+			for( auto& entry : m_scratch ) { fun(entry.m_value); }
+			m_scratch.clear();
+			return due;
+		}
+
+		/// @brief Remove all scheduled values.
+		void Clear() {
+			for( auto& slot : m_slots ) { slot.clear(); }
+			m_size = 0;
+		}
+
+		/// @brief Get the number of scheduled values.
+		/// @return The number of values.
+		auto Size() -> size_t { return m_size; }
+
+		/// @brief Get the current tick, i.e., the number of calls to Advance().
+		/// @return The current tick.
+		auto Now() -> size_t { return m_now; }
+
+	private:
+
+		/// @brief Get a slot.
+		/// @param level The level.
+		/// @param index The index of the slot in the level.
+		/// @return Reference to the slot.
+		auto Slot(size_t level, size_t index) -> std::vector<Entry>& { return m_slots[level * SLOTS + index]; }
+
+		/// @brief Put an entry into the lowest level whose range covers its delay.
+		/// @param entry The entry.
+		void Insert(Entry&& entry) {
+			size_t delay = entry.m_due - m_now;
+			size_t level = 0;
+			while( level < L - 1 && delay >= (1ull << (B * (level + 1))) ) { ++level; }
+			if( delay >= (1ull << (B * L)) ) { //too far, wait in the slot that is redistributed last
+				Slot(L - 1, ((m_now >> (B * (L - 1))) - 1) & MASK).push_back(std::move(entry));
+				return;
+			}
+			Slot(level, (entry.m_due >> (B * level)) & MASK).push_back(std::move(entry));
+		}
+
+		size_t m_now{0}; ///< The current tick.
+		size_t m_size{0}; ///< Number of scheduled values.
+		std::vector<std::vector<Entry>> m_slots; ///< All slots of all levels.
+		std::vector<Entry> m_scratch; ///< Slot being processed, keeps its memory.
+	}; //end of TimingWheel
+
+} //namespace vecs
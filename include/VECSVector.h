@@ -23,25 +23,115 @@ namespace vecs {
 			return static_cast<Vector<T>*>(this)->push_back(std::forward<U>(v));
 		}
 
+		/// @brief Insert a new component value, constructed in place.
+		/// @tparam T The type of the component.
+		/// @param args The constructor arguments.
+		/// @return The index of the new component value.
+		template<typename T, typename... Args>
+		auto emplace_back(Args&&... args) -> size_t {
+			return static_cast<Vector<T>*>(this)->emplace_back(std::forward<Args>(args)...);
+		}
+
 		virtual auto push_back() -> size_t = 0;
 		virtual auto pop_back() -> void = 0; 
 		virtual auto erase(size_t index) -> size_t = 0;
 		virtual void copy(VectorBase* other, size_t from) = 0;
 		virtual void swap(size_t index1, size_t index2) = 0;
 		virtual auto size() const -> size_t = 0;
+		virtual void reserve(size_t n) = 0;
+		virtual void unshare() = 0;
 		virtual auto clone() -> std::unique_ptr<VectorBase> = 0;
+		virtual auto snapshot() -> std::unique_ptr<VectorBase> = 0;
+		virtual auto checksum(size_t seed) -> size_t = 0;
+		virtual auto checksum(size_t seed, std::span<const size_t> rows) -> size_t = 0;
 		virtual void clear() = 0;
 		virtual void print() = 0;
+		virtual void swap_buffers() {} //only double buffered vectors have two buffers
+		virtual void reclaim() {} //only vectors read by optimistic readers retire segments
 	}; //end of VectorBase
 
 
 	/// @brief A vector that stores elements in segments to avoid reallocations. The size of a segment is 2^segmentBits.
+	/// Segments are raw aligned storage, values are constructed when they are pushed and destroyed when they are popped.
+	/// Segments can be shared copy-on-write between a vector and its snapshots. Non-const access to a shared segment first 
+	/// clones this segment, const access never does.
+	/// In parallel mode, values of read mostly components and slots are read by optimistic readers without locking, see
+	/// ReadAddress(). For them, segments that are replaced or removed are retired instead of freed, and freed by reclaim().
 	template<VecsPOD T>
 	class Vector : public VectorBase {
 
-		using Segment_t = std::shared_ptr<std::vector<T>>;
+		/// @brief true if optimistic readers may access the segments concurrently to writers.
+		static constexpr bool RETIRE = LOCKGUARDTYPE == LOCKGUARDTYPE_PARALLEL 
+			&& (is_read_mostly<T>::value || requires { T::READ_OPTIMISTIC; });
+
+		/// @brief Raw aligned storage for the values of one segment. Only the first m_size values are constructed.
+		class Storage {
+			public:
+			Storage(size_t capacity) : m_capacity{capacity},
+				m_data{ static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t{alignof(T)})) } {}
+
+			/// @brief Clone the constructed values of another segment, trivially copyable values are copied in bulk.
+			Storage(const Storage& other) : Storage(other.m_capacity) {
+				if constexpr (std::is_trivially_copyable_v<T>) { 
+					if( other.m_size > 0 ) std::memcpy(m_data, other.m_data, other.m_size * sizeof(T)); 
+				}
+				else { std::uninitialized_copy_n(other.m_data, other.m_size, m_data); }
+				m_size = other.m_size;
+			}
+
+			~Storage() {
+				clear();
+				::operator delete(m_data, std::align_val_t{alignof(T)});
+			}
+
+			auto operator=(const Storage&) -> Storage& = delete;
+
+			/// @brief Construct a value behind the last constructed value.
+			/// @param args The constructor arguments.
+			/// @return Reference to the new value.
+			template<typename... Args>
+			auto emplace_back(Args&&... args) -> T& {
+				assert(m_size < m_capacity);
+				T* ptr = std::construct_at(m_data + m_size, std::forward<Args>(args)...);
+				++m_size;
+				return *ptr;
+			}
+
+			/// @brief Destroy the last constructed value.
+			void pop_back() {
+				assert(m_size > 0);
+				--m_size;
+				std::destroy_at(m_data + m_size);
+			}
+
+			/// @brief Destroy all values, trivially destructible values are dropped in bulk.
+			void clear() {
+				if constexpr (!std::is_trivially_destructible_v<T>) { std::destroy_n(m_data, m_size); }
+				m_size = 0;
+			}
+
+			auto operator[](size_t index) -> T& { return m_data[index]; }
+			auto operator[](size_t index) const -> const T& { return m_data[index]; }
+			auto data() const -> T* { return m_data; }
+			auto size() const -> size_t { return m_size; }
+
+			private:
+			size_t 	m_capacity;	///< Number of values the segment can hold.
+			size_t 	m_size{0};	///< Number of constructed values.
+			T* 		m_data;		///< The raw storage.
+		};
+
+		using Segment_t = std::shared_ptr<Storage>;
 		using Vector_t = std::vector<Segment_t>;
 
+		/// @brief Segment table of optimistic readers. A full table is never reallocated, a larger table is published
+		/// instead, and the old one is retired. So readers holding an old table still read valid memory.
+		struct ReadTable {
+			ReadTable(size_t capacity) : m_capacity{capacity}, m_data{std::make_unique<std::atomic<T*>[]>(capacity)} {}
+			size_t m_capacity;							///< Number of entries.
+			std::unique_ptr<std::atomic<T*>[]> m_data;	///< Data of the segments, nullptr if there is no segment.
+		};
+
 		public:
 
 			/// @brief Iterator for the vector.
@@ -61,57 +151,129 @@ namespace vecs {
 			/// @param segmentBits The number of bits for the segment size.
 			Vector(size_t segmentBits = 6) : m_size{0}, m_segmentBits(segmentBits), m_segmentSize{1ull<<segmentBits}, m_segments{} {
 				assert(segmentBits > 0);
-				m_segments.emplace_back( std::make_shared<std::vector<T>>(m_segmentSize) );
+				AddSegment();
 			}
 
 			~Vector() = default;
 
-			Vector( const Vector& other) : m_size{other.m_size}, m_segmentBits(other.m_segmentBits), m_segmentSize{other.m_segmentSize}, m_segments{} {
-				m_segments.emplace_back( std::make_shared<std::vector<T>>(m_segmentSize) );
+			Vector( const Vector& other) : m_size{0}, m_segmentBits(other.m_segmentBits), m_segmentSize{other.m_segmentSize}, m_segments{} {
+				AddSegment();
 			}
 
 			/// @brief Push a value to the back of the vector.
 			/// @param value The value to push.
 			template<typename U>
 			auto push_back(U&& value) -> size_t {
-				while( Segment(m_size) >= m_segments.size() ) {
-					m_segments.emplace_back( std::make_shared<std::vector<T>>(m_segmentSize) );
-				}
-				++m_size;
-				(*this)[m_size - 1] = std::forward<U>(value);
-				return m_size - 1;
+				return emplace_back(std::forward<U>(value));
+			}
+
+			/// @brief Construct a value at the back of the vector, directly in its slot.
+			/// @param args The constructor arguments.
+			template<typename... Args>
+			auto emplace_back(Args&&... args) -> size_t {
+				while( Segment(m_size) >= m_segments.size() ) { AddSegment(); }
+				Writable(Segment(m_size))->emplace_back(std::forward<Args>(args)...);
+				return m_size++;
 			}
 
 			auto push_back() -> size_t override {
 				return push_back(T{});
 			}
 
-			/// @brief Pop the last value from the vector.
+			/// @brief Pop the last value from the vector and destroy it. Empty segments are freed unless they are reserved,
+			/// or optimistic readers might read them, see reclaim().
 			void pop_back() override {
 				assert(m_size > 0);
 				--m_size;
-				if(	Offset(m_size) == 0 && m_segments.size() > 1 ) {
-					m_segments.pop_back();
+				Writable(Segment(m_size))->pop_back();
+				if(	!RETIRE && Offset(m_size) == 0 && m_segments.size() > std::max<size_t>(1, m_reserved) ) {
+					RemoveSegment();
 				}
 			}
 
-			/// @brief Get the value at an index.
+			/// @brief Get the value at an index for writing. If the segment is shared with a snapshot, it is cloned first.
+			/// @param index The index of the value.
+			auto operator[](size_t index) -> T& {
+				assert(index < m_size);
+				return (*Writable(Segment(index)))[Offset(index)];
+			}
+
+			/// @brief Get the value at an index for reading.
 			/// @param index The index of the value.
-			auto operator[](size_t index) const -> T& {
+			auto operator[](size_t index) const -> const T& {
 				assert(index < m_size);
-				auto seg = Segment(index);
-				auto off = Offset(index);
 				return (*m_segments[Segment(index)])[Offset(index)];
 			}
 
+			/// @brief Get the address of a value, e.g. for prefetching. Must not be called concurrently to writers,
+			/// optimistic readers use ReadAddress().
+			/// @param index The index of the value.
+			/// @return Pointer to the value, or nullptr if the index is out of range.
+			auto address(size_t index) const -> T* {
+				if( index >= m_size ) return nullptr;
+				return m_segments[Segment(index)]->data() + Offset(index);
+			}
+
+			/// @brief Get the address of a value for optimistic readers, concurrently to writers. Only the segment table 
+			/// of the readers is used, which is published atomically, and the memory it points to stays valid until 
+			/// reclaim(). The value itself may be torn or not constructed, so readers must validate it with a sequence lock.
+			/// @param index The index of the value.
+			/// @return Pointer to the value, or nullptr if the index is beyond all segments.
+			auto ReadAddress(size_t index) const -> T* {
+				if constexpr (RETIRE) {
+					auto table = m_readTable.load(std::memory_order_acquire);
+					size_t segment = Segment(index);
+					if( segment >= table->m_capacity ) return nullptr;
+					T* data = table->m_data[segment].load(std::memory_order_acquire);
+					return data ? data + Offset(index) : nullptr;
+				} else { return address(index); }
+			}
+
 			/// @brief Get the value at an index.
 			auto size() const -> size_t override { return m_size; }
 
-			/// @brief Clear the vector. Make sure that one segment is always available.
+			/// @brief Get the number of times a segment was replaced or removed. Addresses of values stay valid as long
+			/// as the epoch does not change, so callers can cache them.
+			/// @return The epoch.
+			auto epoch() const -> size_t { return m_epoch; }
+
+			/// @brief Allocate segments for at least n values. Reserved segments are never freed, so pushing and popping
+			/// values up to this size does not allocate.
+			/// @param n The number of values.
+			void reserve(size_t n) override {
+				m_segments.reserve(Segment(n) + 1);
+				while( m_segments.size() * m_segmentSize < n ) { AddSegment(); }
+				m_reserved = std::max(m_reserved, m_segments.size());
+			}
+
+			/// @brief Get the number of values the allocated segments can hold.
+			auto capacity() const -> size_t { return m_segments.size() * m_segmentSize; }
+
+			/// @brief Clone all segments that are shared with a snapshot. Afterwards, several threads can write
+			/// to different values at the same time, since no write has to clone a segment.
+			void unshare() override {
+				for( size_t s = 0; s < m_segments.size(); ++s ) { Writable(s); }
+			}
+
+			/// @brief Clear the vector. Make sure that one segment is always available, reserved segments are kept.
 			void clear() override {
 				m_size = 0;
-				m_segments.clear();
-				m_segments.emplace_back( std::make_shared<std::vector<T>>(m_segmentSize) );
+				while( m_segments.size() > std::max<size_t>(1, m_reserved) ) { RemoveSegment(); }
+				for( size_t s = 0; s < m_segments.size(); ++s ) { 
+					if( m_segments[s].use_count() > 1 ) { Replace(s, std::make_shared<Storage>(m_segmentSize)); } //still needed by a snapshot
+					else { m_segments[s]->clear(); }
+				}
+			}
+
+			/// @brief Free the segments that were retired while optimistic readers might read them, and the empty segments
+			/// that were kept for them. Call this when no optimistic reader runs, see Registry::Reclaim().
+			void reclaim() override {
+				if constexpr (RETIRE) {
+					size_t used = (m_size + m_segmentSize - 1) >> m_segmentBits;
+					while( m_segments.size() > std::max<size_t>({1, m_reserved, used}) ) { RemoveSegment(); }
+					m_retired.clear();
+					m_tables.erase(m_tables.begin(), m_tables.end() - 1);
+				}
 			}
 
 			/// @brief Erase an entity from the vector.
@@ -127,7 +289,7 @@ namespace vecs {
 
 			/// @brief Copy an entity from another vector to this.
 			void copy(VectorBase* other, size_t from) override {
-				push_back( (static_cast<Vector<T>*>(other))->operator[](from) );
+				push_back( std::as_const(*static_cast<Vector<T>*>(other))[from] );
 			}
 
 			/// @brief Swap two entities in the vector.
@@ -140,6 +302,68 @@ namespace vecs {
 				return std::make_unique<Vector<T>>();
 			}
 
+			/// @brief Create a snapshot of the vector. The snapshot shares all segments copy-on-write.
+			auto snapshot() -> std::unique_ptr<VectorBase> override {
+				auto vec = std::make_unique<Vector<T>>(m_segmentBits);
+				vec->share(*this);
+				return vec;
+			}
+
+			/// @brief Compute a deterministic hash of the values. Values with unique object representations, i.e. without 
+			/// padding bytes, are hashed segment by segment as bytes. Other values are hashed with std::hash if available, 
+			/// e.g. floats or structs with padding bytes that specialize it. Remaining trivially copyable values, e.g. structs
+			/// of floats, are hashed as bytes, so their padding bytes must be deterministic. Other types cannot be hashed.
+			/// @param seed The seed.
+			/// @return The hash.
+			auto checksum(size_t seed) -> size_t override {
+				assert( (BYTES || HASH) && "Checksums need trivially copyable components or std::hash!" );
+				for( size_t s = 0; s * m_segmentSize < m_size; ++s ) {
+					size_t num = std::min(m_segmentSize, m_size - s * m_segmentSize);
+					auto& segment = *m_segments[s];
+					if constexpr (BYTES) { seed = HashBytes(segment.data(), num * sizeof(T), seed); }
+					else if constexpr (HASH) {
+						for( size_t i = 0; i < num; ++i ) { seed = HashCombine(seed, std::hash<T>{}(segment[i])); }
+					}
+				}
+				return HashCombine(seed, m_size);
+			}
+
+			/// @brief Compute the hash of some values in the given order. It equals checksum(seed) of a vector holding 
+			/// only these values, since bytes are copied into chunks of a segment's size, see Archetype::Checksum().
+			/// @param seed The seed.
+			/// @param rows The indices of the values.
+			/// @return The hash.
+			auto checksum(size_t seed, std::span<const size_t> rows) -> size_t override {
+				assert( (BYTES || HASH) && "Checksums need trivially copyable components or std::hash!" );
+				if constexpr (BYTES) {
+					std::vector<std::byte> chunk(std::min(m_segmentSize, rows.size()) * sizeof(T));
+					for( size_t s = 0; s * m_segmentSize < rows.size(); ++s ) {
+						size_t num = std::min(m_segmentSize, rows.size() - s * m_segmentSize);
+						for( size_t i = 0; i < num; ++i ) { 
+							std::memcpy(chunk.data() + i * sizeof(T), address(rows[s * m_segmentSize + i]), sizeof(T)); //keeps padding bytes
+						}
+						seed = HashBytes(chunk.data(), num * sizeof(T), seed);
+					}
+				} else if constexpr (HASH) {
+					for( auto row : rows ) { seed = HashCombine(seed, std::hash<T>{}(std::as_const(*this)[row])); }
+				}
+				return HashCombine(seed, rows.size());
+			}
+
+			/// @brief Share the segments of another vector copy-on-write. Costs O(number of segments).
+			/// @param other The vector to share the segments with.
+			void share(const Vector<T>& other) {
+				while( !m_segments.empty() ) { RemoveSegment(); }
+				m_size = other.m_size;
+				m_segmentBits = other.m_segmentBits;
+				m_segmentSize = other.m_segmentSize;
+				for( auto& seg : other.m_segments ) { 
+					m_segments.push_back(seg); 
+					Publish(m_segments.size() - 1);
+				}
+				m_reserved = other.m_reserved;
+			}
+
 			/// @brief Print the vector.
 			void print() override {
 				std::cout << "Name: " << typeid(T).name() << " ID: " << Type<T>();
@@ -150,6 +374,9 @@ namespace vecs {
 
 		private:
 
+			static constexpr bool HASH = !std::has_unique_object_representations_v<T> && requires(const T& v) { std::hash<T>{}(v); }; ///< Checksums use std::hash.
+			static constexpr bool BYTES = !HASH && std::is_trivially_copyable_v<T>; ///< Checksums hash the bytes.
+
 			/// @brief Compute the segment index of an entity index.
 			/// @param index Entity index.
 			/// @return Index of the segment.
@@ -160,10 +387,544 @@ namespace vecs {
 			/// @return Offset in the segment.
 			inline size_t Offset(size_t index) const { return index & (m_segmentSize-1ul); }
 
+			/// @brief Make sure that a segment is not shared with a snapshot, and can be written to.
+			/// @param segment Index of the segment.
+			/// @return Reference to the segment pointer.
+			inline auto Writable(size_t segment) -> Segment_t& {
+				if( m_segments[segment].use_count() > 1 ) { Replace(segment, std::make_shared<Storage>(*m_segments[segment])); } //copy on write
+				return m_segments[segment];
+			}
+
+			/// @brief Append a new segment.
+			void AddSegment() {
+				m_segments.emplace_back( std::make_shared<Storage>(m_segmentSize) );
+				Publish(m_segments.size() - 1);
+			}
+
+			/// @brief Remove the last segment. 
+			void RemoveSegment() {
+				++m_epoch;
+				Retire(std::move(m_segments.back()));
+				m_segments.pop_back();
+				Publish(m_segments.size());
+			}
+
+			/// @brief Replace a segment by another one.
+			/// @param segment Index of the segment.
+			/// @param seg The new segment.
+			void Replace(size_t segment, Segment_t&& seg) {
+				++m_epoch;
+				Retire(std::move(m_segments[segment]));
+				m_segments[segment] = std::move(seg);
+				Publish(segment);
+			}
+
+			/// @brief Keep a segment that is not used anymore until reclaim(), if optimistic readers might read it.
+			/// @param seg The segment.
+			void Retire(Segment_t&& seg) {
+				if constexpr (RETIRE) { m_retired.push_back(std::move(seg)); }
+			}
+
+			/// @brief Publish the current data of a segment to optimistic readers. If the segment table of the readers is 
+			/// full, a larger table is published and the old one is retired.
+			/// @param segment Index of the segment, segments that do not exist are published as nullptr.
+			void Publish(size_t segment) {
+				if constexpr (RETIRE) {
+					auto table = m_readTable.load(std::memory_order_relaxed);
+					ReadTable* grown = nullptr;
+					if( table == nullptr || segment >= table->m_capacity ) {
+						m_tables.push_back( std::make_unique<ReadTable>(std::max<size_t>(16, 2 * (segment + 1))) );
+						grown = m_tables.back().get();
+						for( size_t s = 0; table != nullptr && s < table->m_capacity; ++s ) { 
+							grown->m_data[s].store(table->m_data[s].load(std::memory_order_relaxed), std::memory_order_relaxed); 
+						}
+						table = grown;
+					}
+					table->m_data[segment].store(segment < m_segments.size() ? m_segments[segment]->data() : nullptr, std::memory_order_release);
+					if( grown ) { m_readTable.store(grown, std::memory_order_release); } //entries are set before
+				}
+			}
+
 			size_t m_size{0};	///< Size of the vector.
 			size_t m_segmentBits;	///< Number of bits for the segment size.
 			size_t m_segmentSize; ///< Size of a segment.
-			Vector_t m_segments{10};	///< Vector holding unique pointers to the segments.
+			size_t m_reserved{0};	///< Number of segments that are never freed, see reserve().
+			size_t m_epoch{0};		///< Number of replaced or removed segments, see epoch().
+			Vector_t m_segments{};	///< Vector holding unique pointers to the segments.
+			std::atomic<ReadTable*> m_readTable{nullptr};	///< Segment table of optimistic readers, see ReadAddress().
+			std::vector<std::unique_ptr<ReadTable>> m_tables;	///< All segment tables of readers, the last one is current.
+			std::vector<Segment_t> m_retired;	///< Segments that optimistic readers might still read, see reclaim().
 	}; //end of Vector
 
+
+	/// @brief A vector for double buffered components. It holds two vectors, the current and the previous buffer.
+	/// Both always have the same size. Swapping the buffers flips two pointers, the current buffer then holds the values
+	/// from two swaps ago, and is supposed to be overwritten during the frame.
+	template<VecsPOD T>
+	class Vector<DoubleBuffered<T>> : public VectorBase {
+
+		public:
+
+			/// @brief Constructor, creates the buffers.
+			/// @param segmentBits The number of bits for the segment size.
+			Vector(size_t segmentBits = 6) : 
+				m_current{std::make_unique<Vector<T>>(segmentBits)}, m_previous{std::make_unique<Vector<T>>(segmentBits)} {}
+
+			~Vector() = default;
+
+			Vector( const Vector& other) : 
+				m_current{std::make_unique<Vector<T>>(*other.m_current)}, m_previous{std::make_unique<Vector<T>>(*other.m_previous)} {}
+
+			/// @brief Constructor, takes two buffers.
+			Vector( std::unique_ptr<Vector<T>>&& current, std::unique_ptr<Vector<T>>&& previous ) : 
+				m_current{std::move(current)}, m_previous{std::move(previous)} {}
+
+			/// @brief Push a value to the back of both buffers.
+			/// @param value The value to push, either a DoubleBuffered<T> or a T.
+			template<typename U>
+			auto push_back(U&& value) -> size_t {
+				const T& v = value;
+				m_previous->push_back(v);
+				return m_current->push_back(v);
+			}
+
+			auto push_back() -> size_t override {
+				m_previous->push_back();
+				return m_current->push_back();
+			}
+
+			void pop_back() override {
+				m_previous->pop_back();
+				m_current->pop_back();
+			}
+
+			/// @brief Get the value of the current buffer at an index.
+			/// @param index The index of the value.
+			auto operator[](size_t index) -> T& { return (*m_current)[index]; }
+			auto operator[](size_t index) const -> const T& { return std::as_const(*m_current)[index]; }
+
+			/// @brief Get the address of a value of the current buffer, see Vector<T>::address().
+			auto address(size_t index) const -> T* { return m_current->address(index); }
+
+			/// @brief Get the address of a value of the current buffer for optimistic readers, see Vector<T>::ReadAddress().
+			auto ReadAddress(size_t index) const -> T* { return m_current->ReadAddress(index); }
+
+			auto size() const -> size_t override { return m_current->size(); }
+
+			void reserve(size_t n) override {
+				m_previous->reserve(n);
+				m_current->reserve(n);
+			}
+
+			void unshare() override {
+				m_previous->unshare();
+				m_current->unshare();
+			}
+
+			void reclaim() override {
+				m_previous->reclaim();
+				m_current->reclaim();
+			}
+
+			void clear() override {
+				m_previous->clear();
+				m_current->clear();
+			}
+
+			auto erase(size_t index) -> size_t override {
+				m_previous->erase(index);
+				return m_current->erase(index);
+			}
+
+			/// @brief Copy an entity from another vector, both buffers.
+			void copy(VectorBase* other, size_t from) override {
+				auto vec = static_cast<Vector<DoubleBuffered<T>>*>(other);
+				m_previous->push_back( std::as_const(vec->Previous())[from] );
+				m_current->push_back( std::as_const(vec->Current())[from] );
+			}
+
+			void swap(size_t index1, size_t index2) override {
+				m_previous->swap(index1, index2);
+				m_current->swap(index1, index2);
+			}
+
+			auto clone() -> std::unique_ptr<VectorBase> override {
+				return std::make_unique<Vector<DoubleBuffered<T>>>();
+			}
+
+			/// @brief Compute a deterministic hash of both buffers.
+			auto checksum(size_t seed) -> size_t override {
+				return m_previous->checksum(m_current->checksum(seed));
+			}
+
+			/// @brief Compute a deterministic hash of some values of both buffers.
+			auto checksum(size_t seed, std::span<const size_t> rows) -> size_t override {
+				return m_previous->checksum(m_current->checksum(seed, rows), rows);
+			}
+
+			/// @brief Create a snapshot of both buffers, sharing their segments copy-on-write.
+			auto snapshot() -> std::unique_ptr<VectorBase> override {
+				auto current = std::make_unique<Vector<T>>();
+				auto previous = std::make_unique<Vector<T>>();
+				current->share(*m_current);
+				previous->share(*m_previous);
+				return std::make_unique<Vector<DoubleBuffered<T>>>(std::move(current), std::move(previous));
+			}
+
+			void print() override {
+				std::cout << "Name: " << typeid(DoubleBuffered<T>).name() << " ID: " << Type<DoubleBuffered<T>>();
+			}
+
+			/// @brief Swap the current and the previous buffer.
+			void swap_buffers() override { std::swap(m_current, m_previous); }
+
+			/// @brief Get the current buffer.
+			auto Current() -> Vector<T>& { return *m_current; }
+
+			/// @brief Get the previous buffer.
+			auto Previous() -> Vector<T>& { return *m_previous; }
+
+		private:
+			std::unique_ptr<Vector<T>> m_current;	///< Buffer that is written this frame.
+			std::unique_ptr<Vector<T>> m_previous;	///< Buffer holding the values of the last frame.
+	}; //end of Vector<DoubleBuffered<T>>
+
+
+	/// @brief Describes a component type that is defined at runtime, e.g. by a scripting layer, see Registry::RegisterComponent().
+	/// Lifetime functions that are nullptr are trivial: values are zero initialized, copied and moved with memcpy, 
+	/// and not destroyed. If only m_move is nullptr, values are moved by copying them.
+	struct ComponentDescriptor {
+		std::string m_name;										///< Unique name, the id of the component is derived from it.
+		size_t m_size{0};										///< Size of a value in bytes.
+		size_t m_align{alignof(std::max_align_t)};				///< Alignment of a value, a power of 2.
+		void (*m_construct)(void* dst){nullptr};				///< Default construct a value.
+		void (*m_copy)(void* dst, const void* src){nullptr};	///< Copy construct a value.
+		void (*m_move)(void* dst, void* src){nullptr};			///< Move construct a value.
+		void (*m_destroy)(void* ptr){nullptr};					///< Destroy a value.
+		size_t (*m_hash)(const void* ptr){nullptr};				///< Hash a value, needed by checksums of values with copy function.
+
+		/// @brief Get the id of the component. It is a hash of the name, distinct from the hashes of C++ types.
+		/// @return The id.
+		auto Id() const -> size_t { return std::hash<std::string>{}("vecs::runtime::" + m_name); }
+
+		/// @brief Create the descriptor of a C++ type, e.g. for script components that are implemented in C++.
+		/// @tparam T The type of the values.
+		/// @param name The name of the component.
+		/// @return The descriptor.
+		template<typename T>
+		static auto Of(std::string name) -> ComponentDescriptor {
+			ComponentDescriptor desc{ std::move(name), sizeof(T), alignof(T) };
+			if constexpr (!std::is_trivially_default_constructible_v<T>) { desc.m_construct = [](void* dst) { ::new(dst) T{}; }; }
+			if constexpr (!std::is_trivially_copyable_v<T>) { 
+				desc.m_copy = [](void* dst, const void* src) { ::new(dst) T(*static_cast<const T*>(src)); }; 
+				desc.m_move = [](void* dst, void* src) { ::new(dst) T(std::move(*static_cast<T*>(src))); }; 
+			}
+			if constexpr (!std::is_trivially_destructible_v<T>) { desc.m_destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); }; }
+			if constexpr (!std::has_unique_object_representations_v<T> && requires(const T& v) { std::hash<T>{}(v); }) { 
+				desc.m_hash = [](const void* ptr) -> size_t { return std::hash<T>{}(*static_cast<const T*>(ptr)); }; 
+			}
+			return desc;
+		}
+	};
+
+
+	/// @brief A type erased column for runtime components, see ComponentDescriptor. Like Vector<T>, values are stored 
+	/// in segments of raw aligned storage of size 2^segmentBits, constructed on push and destroyed on pop, and segments
+	/// are shared copy-on-write with snapshots. Values are accessed as untyped pointers.
+	class RawVector : public VectorBase {
+
+		using Descriptor_t = std::shared_ptr<const ComponentDescriptor>;
+
+		/// @brief Values of at most this size are swapped through a buffer on the stack, larger ones through m_scratch.
+		static constexpr size_t SWAP_BUFFER_SIZE = 64;
+
+		/// @brief Raw aligned storage for the values of one segment. Only the first m_size values are constructed.
+		class Storage {
+			public:
+			Storage(const Descriptor_t& desc, size_t stride, size_t capacity) : m_desc{desc}, m_stride{stride}, m_capacity{capacity},
+				m_data{ static_cast<std::byte*>(::operator new(capacity * stride, std::align_val_t{desc->m_align})) } {}
+
+			/// @brief Clone the constructed values of another segment.
+			Storage(const Storage& other) : Storage(other.m_desc, other.m_stride, other.m_capacity) {
+				if( !m_desc->m_copy ) { 
+					if( other.m_size > 0 ) std::memcpy(m_data, other.m_data, other.m_size * m_stride); 
+					m_size = other.m_size;
+					return;
+				}
+				for( ; m_size < other.m_size; ++m_size ) { m_desc->m_copy(at(m_size), other.at(m_size)); }
+			}
+
+			~Storage() {
+				clear();
+				::operator delete(m_data, std::align_val_t{m_desc->m_align});
+			}
+
+			auto operator=(const Storage&) -> Storage& = delete;
+
+			/// @brief Construct a value behind the last constructed value.
+			/// @param value Pointer to the value to copy, or nullptr to default construct the value.
+			/// @return Pointer to the new value.
+			auto push_back(const void* value) -> void* {
+				assert(m_size < m_capacity);
+				void* ptr = at(m_size);
+				if( value ) { 
+					if( m_desc->m_copy ) m_desc->m_copy(ptr, value); 
+					else std::memcpy(ptr, value, m_desc->m_size); 
+				}
+				else if( m_desc->m_construct ) { m_desc->m_construct(ptr); } 
+				else { std::memset(ptr, 0, m_desc->m_size); }
+				++m_size;
+				return ptr;
+			}
+
+			/// @brief Destroy the last constructed value.
+			void pop_back() {
+				assert(m_size > 0);
+				--m_size;
+				if( m_desc->m_destroy ) m_desc->m_destroy(at(m_size));
+			}
+
+			/// @brief Destroy all values.
+			void clear() {
+				if( m_desc->m_destroy ) { for( size_t i = 0; i < m_size; ++i ) m_desc->m_destroy(at(i)); }
+				m_size = 0;
+			}
+
+			auto at(size_t index) const -> std::byte* { return m_data + index * m_stride; }
+			auto size() const -> size_t { return m_size; }
+
+			private:
+			Descriptor_t m_desc;	///< Type of the values.
+			size_t m_stride;		///< Distance between two values in bytes.
+			size_t m_capacity;		///< Number of values the segment can hold.
+			size_t m_size{0};		///< Number of constructed values.
+			std::byte* m_data;		///< The raw storage.
+		};
+
+		using Segment_t = std::shared_ptr<Storage>;
+
+		public:
+
+			/// @brief Constructor, creates the vector.
+			/// @param desc The type of the values.
+			/// @param segmentBits The number of bits for the segment size.
+			RawVector(const Descriptor_t& desc, size_t segmentBits = 6) : m_desc{desc}, 
+				m_stride{ (std::max<size_t>(desc->m_size, 1) + desc->m_align - 1) & ~(desc->m_align - 1) }, 
+				m_segmentBits{segmentBits}, m_segmentSize{1ull << segmentBits} {
+				assert(segmentBits > 0 && std::has_single_bit(desc->m_align));
+				m_segments.emplace_back( std::make_shared<Storage>(m_desc, m_stride, m_segmentSize) );
+				if( m_stride > SWAP_BUFFER_SIZE || desc->m_align > alignof(std::max_align_t) ) {
+					m_scratch = std::make_unique<Storage>(m_desc, m_stride, 1);
+				}
+			}
+
+			/// @brief Push a copy of a value to the back of the vector.
+			/// @param value Pointer to the value, or nullptr to push a default value.
+			/// @return The index of the new value.
+			auto push_back(const void* value) -> size_t {
+				while( Segment(m_size) >= m_segments.size() ) {
+					m_segments.emplace_back( std::make_shared<Storage>(m_desc, m_stride, m_segmentSize) );
+				}
+				Writable(Segment(m_size))->push_back(value);
+				return m_size++;
+			}
+
+			auto push_back() -> size_t override { return push_back(nullptr); }
+
+			/// @brief Pop the last value from the vector and destroy it. Empty segments are freed unless they are reserved.
+			void pop_back() override {
+				assert(m_size > 0);
+				--m_size;
+				Writable(Segment(m_size))->pop_back();
+				if(	Offset(m_size) == 0 && m_segments.size() > std::max<size_t>(1, m_reserved) ) {
+					m_segments.pop_back();
+				}
+			}
+
+			/// @brief Get the address of a value for writing. If the segment is shared with a snapshot, it is cloned first.
+			/// @param index The index of the value.
+			auto operator[](size_t index) -> void* {
+				assert(index < m_size);
+				return Writable(Segment(index))->at(Offset(index));
+			}
+
+			/// @brief Get the address of a value for reading.
+			/// @param index The index of the value.
+			auto operator[](size_t index) const -> const void* {
+				assert(index < m_size);
+				return m_segments[Segment(index)]->at(Offset(index));
+			}
+
+			/// @brief Get the address of a value for prefetching, see Vector<T>::address().
+			/// @param index The index of the value.
+			/// @return Pointer to the value, or nullptr if the index is out of range.
+			auto address(size_t index) const -> void* {
+				if( index >= m_size ) return nullptr;
+				return m_segments[Segment(index)]->at(Offset(index));
+			}
+
+			/// @brief Overwrite a value with a copy of another value.
+			/// @param index The index of the value.
+			/// @param value Pointer to the new value.
+			void assign(size_t index, const void* value) {
+				void* ptr = (*this)[index];
+				if( ptr == value ) return;
+				if( m_desc->m_destroy ) m_desc->m_destroy(ptr);
+				if( m_desc->m_copy ) m_desc->m_copy(ptr, value);
+				else std::memcpy(ptr, value, m_desc->m_size);
+			}
+
+			auto size() const -> size_t override { return m_size; }
+
+			/// @brief Get the type of the values.
+			auto descriptor() const -> const ComponentDescriptor& { return *m_desc; }
+
+			/// @brief Allocate segments for at least n values, see Vector<T>::reserve().
+			/// @param n The number of values.
+			void reserve(size_t n) override {
+				m_segments.reserve(Segment(n) + 1);
+				while( m_segments.size() * m_segmentSize < n ) {
+					m_segments.emplace_back( std::make_shared<Storage>(m_desc, m_stride, m_segmentSize) );
+				}
+				m_reserved = std::max(m_reserved, m_segments.size());
+			}
+
+			/// @brief Clone all segments that are shared with a snapshot, see Vector<T>::unshare().
+			void unshare() override {
+				for( size_t s = 0; s < m_segments.size(); ++s ) { Writable(s); }
+			}
+
+			/// @brief Clear the vector. Make sure that one segment is always available, reserved segments are kept.
+			void clear() override {
+				m_size = 0;
+				if( m_reserved > 0 ) { 
+					m_segments.resize(m_reserved);
+					for( auto& seg : m_segments ) { //a shared segment is still needed by a snapshot
+						if( seg.use_count() > 1 ) seg = std::make_shared<Storage>(m_desc, m_stride, m_segmentSize);
+						else seg->clear();
+					}
+					return; 
+				}
+				m_segments.clear();
+				m_segments.emplace_back( std::make_shared<Storage>(m_desc, m_stride, m_segmentSize) );
+			}
+
+			/// @brief Erase an entity from the vector. The last value is moved to the erased one.
+			auto erase(size_t index) -> size_t override {
+				size_t last = size() - 1;
+				assert(index <= last);
+				if( index < last ) {
+					void* dst = (*this)[index];
+					if( m_desc->m_destroy ) m_desc->m_destroy(dst);
+					MoveConstruct(dst, (*this)[last]); //the moved from value is destroyed by pop_back()
+				}
+				pop_back();
+				return last;
+			}
+
+			/// @brief Copy an entity from another vector to this.
+			void copy(VectorBase* other, size_t from) override {
+				push_back( std::as_const(*static_cast<RawVector*>(other))[from] );
+			}
+
+			/// @brief Swap two entities in the vector.
+			void swap(size_t index1, size_t index2) override {
+				if( index1 == index2 ) return;
+				void* a = (*this)[index1];
+				void* b = (*this)[index2];
+				alignas(std::max_align_t) std::byte buffer[SWAP_BUFFER_SIZE];
+				void* tmp = m_scratch ? m_scratch->at(0) : buffer; //the scratch value is never constructed
+				Relocate(tmp, a);
+				Relocate(a, b);
+				Relocate(b, tmp);
+			}
+
+			/// @brief Clone the vector, the clone is empty.
+			auto clone() -> std::unique_ptr<VectorBase> override {
+				return std::make_unique<RawVector>(m_desc, m_segmentBits);
+			}
+
+			/// @brief Create a snapshot of the vector. The snapshot shares all segments copy-on-write.
+			auto snapshot() -> std::unique_ptr<VectorBase> override {
+				auto vec = std::make_unique<RawVector>(m_desc, m_segmentBits);
+				vec->m_size = m_size;
+				vec->m_segments = m_segments;
+				vec->m_reserved = m_reserved;
+				return vec;
+			}
+
+			/// @brief Compute a deterministic hash of the values. Values are hashed by the hash function of the descriptor.
+			/// Without one, values are hashed as bytes, so their padding bytes must be deterministic, and values with copy 
+			/// function cannot be hashed.
+			/// @param seed The seed.
+			/// @return The hash.
+			auto checksum(size_t seed) -> size_t override {
+				assert( (m_desc->m_hash || !m_desc->m_copy) && "Runtime components with copy function need a hash function for checksums!" );
+				for( size_t s = 0; s * m_segmentSize < m_size; ++s ) {
+					size_t num = std::min(m_segmentSize, m_size - s * m_segmentSize);
+					for( size_t i = 0; i < num; ++i ) { 
+						const std::byte* ptr = m_segments[s]->at(i);
+						seed = m_desc->m_hash ? HashCombine(seed, m_desc->m_hash(ptr)) : HashBytes(ptr, m_desc->m_size, seed); 
+					}
+				}
+				return HashCombine(seed, m_size);
+			}
+
+			/// @brief Compute the hash of some values in the given order, equal to checksum(seed) of a vector holding 
+			/// only these values.
+			/// @param seed The seed.
+			/// @param rows The indices of the values.
+			/// @return The hash.
+			auto checksum(size_t seed, std::span<const size_t> rows) -> size_t override {
+				assert( (m_desc->m_hash || !m_desc->m_copy) && "Runtime components with copy function need a hash function for checksums!" );
+				for( auto row : rows ) { 
+					auto ptr = static_cast<const std::byte*>(std::as_const(*this)[row]);
+					seed = m_desc->m_hash ? HashCombine(seed, m_desc->m_hash(ptr)) : HashBytes(ptr, m_desc->m_size, seed); 
+				}
+				return HashCombine(seed, rows.size());
+			}
+
+			/// @brief Print the vector.
+			void print() override {
+				std::cout << "Name: " << m_desc->m_name << " ID: " << m_desc->Id();
+			}
+
+		private:
+
+			/// @brief Compute the segment index of an entity index.
+			inline size_t Segment(size_t index) const { return index >> m_segmentBits; }
+
+			/// @brief Compute the offset of an entity index in a segment.
+			inline size_t Offset(size_t index) const { return index & (m_segmentSize-1ul); }
+
+			/// @brief Make sure that a segment is not shared with a snapshot, and can be written to.
+			inline auto Writable(size_t segment) -> Segment_t& {
+				auto& seg = m_segments[segment];
+				if( seg.use_count() > 1 ) { seg = std::make_shared<Storage>(*seg); } //copy on write
+				return seg;
+			}
+
+			/// @brief Move construct a value into uninitialized memory.
+			void MoveConstruct(void* dst, void* src) {
+				if( m_desc->m_move ) m_desc->m_move(dst, src);
+				else if( m_desc->m_copy ) m_desc->m_copy(dst, src);
+				else std::memcpy(dst, src, m_desc->m_size);
+			}
+
+			/// @brief Move a value into uninitialized memory and destroy the source.
+			void Relocate(void* dst, void* src) {
+				MoveConstruct(dst, src);
+				if( m_desc->m_destroy ) m_desc->m_destroy(src);
+			}
+
+			Descriptor_t m_desc;		///< Type of the values.
+			size_t m_stride;			///< Distance between two values in bytes.
+			size_t m_size{0};			///< Size of the vector.
+			size_t m_segmentBits;		///< Number of bits for the segment size.
+			size_t m_segmentSize;		///< Size of a segment.
+			size_t m_reserved{0};		///< Number of segments that are never freed, see reserve().
+			std::vector<Segment_t> m_segments;	///< The segments.
+			std::unique_ptr<Storage> m_scratch;	///< Storage for one value to swap large values, see swap().
+	}; //end of RawVector
+
 }
@@ -5,6 +5,7 @@
 #include <random>
 #include <iostream>
 #include <string>
+#include <thread>
 
 #include "VECS.h"
 
@@ -261,7 +262,10 @@ void test_archetype() {
 		check( arch.Size() == 3 );
 		std::cout << "\nArchetype size: " << arch.Size() << std::endl;
 		arch.Print();
-		vecs::Archetype::m_gaps.clear();
+		check( arch.Gaps() == 3 && arch.Number() == 6 );
+		while( arch.HasGaps() ) { arch.FillGap(); }
+		check( arch.Size() == 3 && arch.Number() == 3 );
+		vecs::Archetype::m_iteratingArchetype = nullptr;
 	}
 
 	{
@@ -336,8 +340,109 @@ void test_archetype() {
 
 }
 
-void test_mutex() {
+void test_archetypemap() {
+	std::cout << "\x1b[37m testing archetype map...";
+	{
+		vecs::ArchetypeMap map(2);
+		std::vector<vecs::Archetype*> archs;
+		for( size_t i=0; i<100; ++i ) {
+			archs.push_back( map.Insert( i, std::vector<size_t>{i, i+1}, std::make_unique<vecs::Archetype>() ) );
+		}
+		check( map.size() == 100 );
+		for( size_t i=0; i<100; ++i ) { 
+			check( map.Find( i, std::vector<size_t>{i, i+1} ) == archs[i] ); 
+		}
+		check( map.Find( 100, std::vector<size_t>{100, 101} ) == nullptr );
+
+		//same hash, different signatures -> different archetypes
+		auto a1 = map.Insert( 1000, std::vector<size_t>{1, 2, 3}, std::make_unique<vecs::Archetype>() );
+		auto a2 = map.Insert( 1000, std::vector<size_t>{4, 5}, std::make_unique<vecs::Archetype>() );
+		check( a1 != a2 );
+		check( map.Find( 1000, std::vector<size_t>{1, 2, 3} ) == a1 );
+		check( map.Find( 1000, std::vector<size_t>{4, 5} ) == a2 );
+		check( map.Find( 1000, std::vector<size_t>{1, 2} ) == nullptr );
+
+		size_t n = 0;
+		for( auto& entry : map ) { check( entry.m_arch.get() != nullptr ); ++n; }
+		check( n == 102 );
+	}
+	std::cout << "\x1b[32m passed\n";
+}
 
+template<typename M>
+void test_mutex_type() {
+	M mutex;
+	size_t counter = 0;
+	size_t reads = 0;
+	{
+		std::vector<std::jthread> threads;
+		for( int t=0; t<4; ++t ) {
+			threads.emplace_back( [&](){ 
+				for( int i=0; i<10000; ++i ) {
+					{ vecs::LockGuard<vecs::LOCKGUARDTYPE_PARALLEL, M> lock(&mutex); ++counter; }
+					{ vecs::LockGuardShared<vecs::LOCKGUARDTYPE_PARALLEL, M> lock(&mutex); if( counter > 0 ) { std::atomic_ref<size_t>(reads)++; } }
+				}
+			} );
+		}
+	}
+	check( counter == 40000 );
+	check( reads == 40000 );
+}
+
+void test_mutex() {
+	std::cout << "\x1b[37m testing mutex...";
+	test_mutex_type<std::shared_mutex>();
+	test_mutex_type<vecs::SpinMutex>();
+	test_mutex_type<vecs::TicketMutex>();
+	test_mutex_type<vecs::RWSpinMutex>();
+	test_mutex_type<vecs::HybridMutex>();
+	check( sizeof(vecs::RWSpinMutex) <= 8 );
+
+	vecs::TicketMutex ticket; //no shared mode, a held mutex cannot be locked again
+	check( ticket.try_lock() && !ticket.try_lock() && !ticket.try_lock_shared() );
+	ticket.unlock();
+	check( ticket.try_lock_shared() );
+	ticket.unlock_shared();
+	check( !vecs::HasSharedMode<vecs::TicketMutex>() && vecs::HasSharedMode<vecs::RWSpinMutex>() );
+
+	vecs::StripedCounter<16, std::atomic<int64_t>> counter;
+	{
+		std::vector<std::jthread> threads;
+		for( int t=0; t<4; ++t ) {
+			threads.emplace_back( [&](){ for( int i=0; i<10000; ++i ) { counter.Add(2); counter.Add(-1); } } );
+		}
+	}
+	check( counter.Get() == 40000 );
+	counter.Reset();
+	check( counter.Get() == 0 );
+	check( alignof(vecs::CacheLinePadded<int>) == vecs::CACHE_LINE_SIZE );
+
+	vecs::SeqLock seqLock;
+	size_t a = 0, b = 0;
+	bool consistent = true;
+	{
+		std::jthread writer{ [&](){ 
+			for( size_t i=1; i<=10000; ++i ) { 
+				vecs::SeqLockGuard<vecs::LOCKGUARDTYPE_PARALLEL> guard(&seqLock);
+				std::atomic_ref<size_t>(a).store(i, std::memory_order_relaxed);
+				std::atomic_ref<size_t>(b).store(i, std::memory_order_relaxed);
+			} 
+		} };
+		std::jthread reader{ [&](){ 
+			size_t ra = 0, rb = 0;
+			do {
+				size_t seq;
+				do {
+					seq = seqLock.ReadBegin();
+					ra = std::atomic_ref<size_t>(a).load(std::memory_order_relaxed);
+					rb = std::atomic_ref<size_t>(b).load(std::memory_order_relaxed);
+				} while( seqLock.ReadRetry(seq) );
+				if( ra != rb ) consistent = false;
+			} while( ra < 10000 );
+		} };
+	}
+	check( consistent );
+	std::cout << "\x1b[32m passed\n";
 }
 
 void test_vecs();
@@ -357,6 +462,7 @@ int main() {
 	test_vector();
 	test_slotmap();
 	test_archetype();
+	test_archetypemap();
 	test_mutex();
 	test_registry();
 }
@@ -0,0 +1,58 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//Replaces the global allocation functions to count heap allocations, see test_fixed_capacity().
+//Only allocations of a thread that turned counting on are counted. The replacements live in their own
+//translation unit, so the compiler never sees them together with the calls of new and delete.
+
+namespace {
+	thread_local bool t_counting = false;
+	std::atomic<size_t> g_allocations{0};
+
+	void* allocate(std::size_t size) {
+		if( t_counting ) ++g_allocations;
+		if( void* ptr = std::malloc(size ? size : 1) ) return ptr;
+		throw std::bad_alloc{};
+	}
+
+	void* allocate(std::size_t size, std::align_val_t align) {
+		if( t_counting ) ++g_allocations;
+		size_t a = (size_t)align;
+	#if defined(_MSC_VER)
+		if( void* ptr = _aligned_malloc(size ? size : 1, a) ) return ptr;
+	#else
+		if( void* ptr = std::aligned_alloc(a, (size + a - 1) / a * a) ) return ptr;
+	#endif
+		throw std::bad_alloc{};
+	}
+
+	void deallocate(void* ptr, std::align_val_t) noexcept {
+	#if defined(_MSC_VER)
+		_aligned_free(ptr);
+	#else
+		std::free(ptr);
+	#endif
+	}
+}
+
+/// @brief Turn counting of allocations of the calling thread on or off.
+/// @param on If true, count allocations.
+void count_allocations( bool on ) { t_counting = on; }
+
+/// @brief Get the number of counted allocations.
+size_t allocations() { return g_allocations; }
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return allocate(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return allocate(size, align); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t align) noexcept { deallocate(ptr, align); }
+void operator delete[](void* ptr, std::align_val_t align) noexcept { deallocate(ptr, align); }
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept { deallocate(ptr, align); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t align) noexcept { deallocate(ptr, align); }
@@ -12,6 +12,10 @@
 bool boolprint = false;
 void check( bool b, std::string_view msg = "" );
 
+//count heap allocations of the calling thread, see testvecs_alloc.cpp and test_fixed_capacity()
+void count_allocations( bool on );
+size_t allocations();
+
 struct test_struct {
 	int i;
 	float f;
@@ -287,6 +291,877 @@ int test1() {
 }
 
 
+struct config_t {
+	int m_level;
+	float m_scale;
+};
+
+template<>
+struct vecs::is_read_mostly<config_t> : std::true_type {};
+
+void test_read_mostly() {
+	vecs::Registry system;
+
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<100; ++i ) { handles.push_back( system.Insert(config_t{i, (float)i}, i) ); }
+	for( int i=0; i<100; ++i ) { check( system.Get<config_t>(handles[i]).m_level == i ); }
+	auto [cfg, ival] = system.Get<config_t, int>(handles[5]);
+	check( cfg.m_level == 5 && ival == 5 );
+
+	int n = 0;
+	for( auto [handle, cfg] : system.template GetView<vecs::Handle, config_t>() ) {
+		check( cfg.m_level == system.Get<int>(handle) );
+		++n;
+	}
+	check( n == 100 );
+
+	if constexpr (vecs::LOCKGUARDTYPE == vecs::LOCKGUARDTYPE_PARALLEL) {
+		bool consistent = true;
+		std::jthread writer{ [&](){ 
+			for( int i=0; i<10000; ++i ) { system.Put(handles[i % 100], config_t{i, (float)i}); } 
+		} };
+		std::jthread reader{ [&](){ 
+			for( int i=0; i<10000; ++i ) {
+				auto c = system.Get<config_t>(handles[i % 100]);
+				if( (float)c.m_level != c.m_scale ) consistent = false; 
+			}
+		} };
+		writer.join();
+		reader.join();
+		check( consistent );
+
+		//concurrent inserts grow and reallocate the slot map and the archetype, erases move entities
+		std::jthread inserter{ [&](){ 
+			std::vector<vecs::Handle> added;
+			for( int i=0; i<20000; ++i ) { 
+				added.push_back( system.Insert(config_t{i, (float)i}, i) ); 
+				if( i % 3 == 0 ) { system.Erase(added[i / 2]); }
+			} 
+		} };
+		std::vector<std::jthread> readers;
+		for( int t=0; t<4; ++t ) {
+			readers.emplace_back( [&](){ 
+				for( int i=0; i<50000; ++i ) {
+					auto c = system.Get<config_t>(handles[i % 100]);
+					if( (float)c.m_level != c.m_scale ) consistent = false; 
+				}
+			} );
+		}
+		inserter.join();
+		for( auto& r : readers ) { r.join(); }
+		check( consistent );
+		system.Reclaim();
+		for( int i=0; i<100; ++i ) { auto c = system.Get<config_t>(handles[i]); check( (float)c.m_level == c.m_scale ); }
+	}
+}
+
+
+void test_double_buffered() {
+	struct pos_t { float x; };
+	vecs::Registry system;
+
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<100; ++i ) { handles.push_back( system.Insert(vecs::DoubleBuffered<pos_t>{{(float)i}}, i) ); }
+	auto h = handles[10];
+	check( system.Get<vecs::Prev<pos_t>>(h).x == 10.0f && system.Get<vecs::Cur<pos_t>>(h).x == 10.0f );
+	check( system.Has<vecs::Cur<pos_t>>(h) && system.Has<vecs::DoubleBuffered<pos_t>>(h) );
+
+	system.Put(h, vecs::DoubleBuffered<pos_t>{{20.0f}});
+	check( system.Get<vecs::Prev<pos_t>>(h).x == 10.0f && system.Get<vecs::Cur<pos_t>>(h).x == 20.0f );
+	system.SwapBuffers();
+	check( system.Get<vecs::Prev<pos_t>>(h).x == 20.0f );
+
+	for( int frame=0; frame<3; ++frame ) {
+		for( auto [handle, prev, cur] : system.template GetView<vecs::Handle, vecs::Prev<pos_t>, vecs::Cur<pos_t>&>() ) {
+			cur = pos_t{prev.x + 1.0f};
+		}
+		system.SwapBuffers();
+	}
+	check( system.Get<vecs::Prev<pos_t>>(h).x == 23.0f );
+	check( system.Get<vecs::Prev<pos_t>>(handles[0]).x == 3.0f );
+
+	system.AddTags(h, 1ull); //move both buffers to a new archetype
+	check( system.Get<vecs::Prev<pos_t>>(h).x == 23.0f && system.Get<vecs::Cur<pos_t>>(h).x == 22.0f );
+	system.Erase(handles[0]);
+	check( system.Get<vecs::Prev<pos_t>>(handles[99]).x == 102.0f );
+
+	auto h2 = system.Insert(5.0);
+	auto cur = system.Get<vecs::Cur<pos_t>&>(h2); //adds the double buffered component
+	cur = pos_t{7.0f};
+	system.SwapBuffers();
+	check( system.Get<vecs::Prev<pos_t>>(h2).x == 7.0f );
+	system.Erase<vecs::DoubleBuffered<pos_t>>(h2);
+	check( !system.Has<vecs::Prev<pos_t>>(h2) );
+}
+
+
+void test_snapshot() {
+	vecs::Registry system;
+
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<1000; ++i ) { handles.push_back( system.Insert(i, (float)i) ); }
+	auto ref = system.Get<int&>(handles[999]);
+	check( ref() == 999 ); //caches the slot
+	auto snap = system.Snapshot();
+
+	system.Put(handles[10], 100); //clones one segment
+	for( auto [handle, i] : system.template GetView<vecs::Handle, int&>() ) { i = i + 1; }
+	system.Erase(handles[20]);
+	system.AddTags(handles[30], 1ull);
+	system.Put(handles[40], 'a');
+	auto h = system.Insert(5000);
+	system.Validate();
+
+	check( snap.Size() == 1000 && system.Size() == 1000 );
+	check( snap.Get<int>(handles[10]) == 10 && system.Get<int>(handles[10]) == 101 );
+	check( snap.Exists(handles[20]) && !system.Exists(handles[20]) );
+	check( snap.Get<int>(handles[20]) == 20 );
+	check( snap.Get<int>(handles[30]) == 30 && snap.Get<float>(handles[30]) == 30.0f );
+	check( !snap.Has<char>(handles[40]) && system.Has<char>(handles[40]) );
+	check( !snap.Exists(h) );
+
+	ref = 7; //the slot segment was cloned, and the entity was moved by the erasure
+	check( ref() == 7 && system.Get<int>(handles[999]) == 7 && snap.Get<int>(handles[999]) == 999 );
+
+	int sum = 0, num = 0;
+	for( auto [handle, i, f] : snap.GetView<vecs::Handle, int, float>() ) { 
+		check( i == (int)f );
+		sum += i; ++num; 
+	}
+	check( num == 1000 && sum == 999*1000/2 );
+	num = 0;
+	for( auto i : system.template GetView<int>() ) { ++num; }
+	check( num == 1000 );
+}
+
+
+void test_rewind() {
+	vecs::Registry system;
+
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<1000; ++i ) { handles.push_back( system.Insert(i, (float)i) ); }
+	check( !system.Rewind(0) ); //no history by default
+	system.SetHistorySize(8);
+	system.SaveTick(0);
+
+	system.Put(handles[10], 100);
+	system.Erase(handles[20]);
+	system.AddTags(handles[30], 1ull);
+	system.SaveTick(1);
+
+	for( auto [handle, i] : system.template GetView<vecs::Handle, int&>() ) { i = i + 1; }
+	auto h = system.Insert(5000, 'a');
+	system.Put(handles[40], 'b');
+	check( system.Size() == 1000 && system.Exists(h) );
+
+	check( system.Rewind(1) );
+	system.Validate();
+	check( system.Size() == 999 && !system.Exists(h) );
+	check( system.Get<int>(handles[10]) == 100 && system.Get<int>(handles[11]) == 11 );
+	check( !system.Exists(handles[20]) && system.Has(handles[30], 1ull) && !system.Has<char>(handles[40]) );
+	size_t num = 0;
+	for( auto c : system.template GetView<char>() ) { ++num; }
+	check( num == 0 );
+	bool aliased = false; //the slot of h has its old version, so a new entity in this slot gets the same handle
+	for( int i=0; i<64 && !aliased; ++i ) { aliased = system.Insert(6000).GetValue() == h.GetValue(); }
+	check( aliased && system.Exists(h) && system.Get<int>(h) == 6000 );
+
+	for( auto [handle, i] : system.template GetView<vecs::Handle, int&>() ) { i = 0; }
+	check( system.Rewind(0) );
+	check( system.Size() == 1000 && system.Exists(handles[20]) && !system.Has(handles[30], 1ull) );
+	check( system.Get<int>(handles[10]) == 10 && system.Get<int>(handles[20]) == 20 );
+	check( !system.Rewind(1) ); //later ticks are dropped
+
+	system.SetHistorySize(2);
+	for( size_t tick=0; tick<4; ++tick ) { system.Put(handles[0], (int)tick); system.SaveTick(tick); }
+	check( !system.Rewind(1) && system.Rewind(2) && system.Get<int>(handles[0]) == 2 );
+	auto h2 = system.Insert(7, 7.0f); //reuses the slot that was free at tick 2
+	check( system.Exists(h2) && system.Get<int>(h2) == 7 && system.Size() == 1001 );
+
+	system.EraseAfter(handles[1], 2); //scheduled erasures are rewound as well
+	system.SaveTick(10);
+	system.EraseAfter(h2, 1);
+	system.Tick();
+	system.Tick();
+	check( !system.Exists(handles[1]) && !system.Exists(h2) );
+	check( system.Rewind(10) && system.Exists(handles[1]) && system.Exists(h2) );
+	check( system.Tick() == 0 && system.Exists(h2) ); //scheduled after the tick, dropped
+	check( system.Tick() == 1 && !system.Exists(handles[1]) );
+}
+
+
+struct padded_t {
+	char m_char;
+	int m_int;
+};
+
+struct float_pair_t {
+	float x;
+	float y;
+};
+
+template<>
+struct std::hash<padded_t> {
+	size_t operator()(const padded_t& v) const { return vecs::HashCombine(std::hash<char>{}(v.m_char), std::hash<int>{}(v.m_int)); }
+};
+
+void test_checksum() {
+	auto build = [](vecs::Registry& system, int n) {
+		std::vector<vecs::Handle> handles;
+		for( int i=0; i<n; ++i ) { handles.push_back( system.Insert(i, (float)i, std::string("a")) ); }
+		for( int i=0; i<n; i+=3 ) { system.Put(handles[i], 'c'); }
+		for( int i=0; i<n; i+=7 ) { system.Erase(handles[i]); }
+		return handles;
+	};
+	vecs::Registry system1, system2;
+	auto handles1 = build(system1, 2000);
+	system1.SetHistorySize(1);
+	system1.SaveTick(0);
+	auto handles2 = build(system2, 2000);
+	check( system1.Checksum() == system2.Checksum() );
+
+	system1.Put(handles1[1], 5);
+	check( system1.Checksum() != system2.Checksum() );
+	system2.Put(handles2[1], 5);
+	check( system1.Checksum() == system2.Checksum() );
+	system1.Put(handles1[2], std::string("b"));
+	check( system1.Checksum() != system2.Checksum() );
+	check( system1.Rewind(0) && system1.Checksum() != system2.Checksum() );
+	system1.Put(handles1[1], 5);
+	check( system1.Checksum() == system2.Checksum() );
+
+	vecs::Registry system3; //components with padding bytes are hashed with std::hash
+	auto h3 = system3.Insert(padded_t{'a', 1});
+	size_t sum = system3.Checksum();
+	system3.Put(h3, padded_t{'b', 1});
+	check( system3.Checksum() != sum );
+	system3.Put(h3, padded_t{'a', 1});
+	check( system3.Checksum() == sum );
+
+	vecs::Registry system5, system6; //structs of floats have neither unique representations nor std::hash
+	std::vector<vecs::Handle> handles5, handles6;
+	for( int i=0; i<16; ++i ) { handles5.push_back( system5.Insert(float_pair_t{(float)i, 1.0f}) ); } 
+	for( int i=0; i<16; ++i ) { handles6.push_back( system6.Insert(float_pair_t{(float)i, 1.0f}) ); } //16 use every slot map once
+	check( system5.Checksum() == system6.Checksum() );
+	system6.Put(handles6[3], float_pair_t{3.5f, 1.0f});
+	check( system5.Checksum() != system6.Checksum() );
+
+	vecs::Registry system7, system8; //gaps are skipped, so compaction does not change the checksum
+	system7.SetDeferredCompaction(true);
+	system8.SetDeferredCompaction(true);
+	std::vector<vecs::Handle> handles7, handles8;
+	for( int i=0; i<32; ++i ) { handles7.push_back( system7.Insert(i, float_pair_t{(float)i, 1.0f}, padded_t{'a', i}) ); } 
+	for( int i=0; i<32; ++i ) { handles8.push_back( system8.Insert(i, float_pair_t{(float)i, 1.0f}, padded_t{'a', i}) ); }
+	for( int i : {3, 10, 30, 31} ) { system7.Erase(handles7[i]); system8.Erase(handles8[i]); }
+	check( system7.Maintain(100) == 0 && system7.Checksum() == system8.Checksum() );
+	system8.Put(handles8[29], 100);
+	check( system7.Checksum() != system8.Checksum() );
+
+	std::vector<int> values(1000, 0);
+	for( int r=0; r<100; ++r ) { vecs::ParallelFor(values.size(), [&](size_t i){ values[i] = (int)i + r; }); } //threads are reused
+	check( std::ranges::equal(values, std::views::iota(99, 1099)) );
+	vecs::ParallelFor(10, [&](size_t i){ vecs::ParallelFor(100, [&](size_t j){ values[i * 100 + j] = 1; }); }); //nested loops run serially
+	check( std::ranges::count(values, 1) == 1000 );
+}
+
+
+void test_maintain() {
+	vecs::Registry system;
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<1000; ++i ) { handles.push_back( system.Insert(i, (float)i) ); }
+	for( int i=1000; i<1200; ++i ) { handles.push_back( system.Insert(i, 'c') ); }
+
+	system.SetDeferredCompaction(true);
+	for( int i=0; i<1200; i+=2 ) { system.Erase(handles[i]); } //600 gaps
+	check( system.Size() == 600 );
+	int num = 0;
+	for( auto [handle, i] : system.template GetView<vecs::Handle, int>() ) { check( handle.IsValid() && i % 2 == 1 ); ++num; }
+	check( num == 600 );
+
+	check( system.Maintain(100) == 500 );
+	for( auto [handle, i] : system.template GetView<vecs::Handle, int&>() ) { i = -i; } //gaps are skipped
+	check( system.Maintain(std::chrono::milliseconds(100)) == 0 );
+	system.Validate();
+	for( int i=1; i<1200; i+=2 ) { check( system.Get<int>(handles[i]) == -i ); }
+
+	system.SetDeferredCompaction(false);
+	for( auto [handle, i] : system.template GetView<vecs::Handle, int>() ) { if( (-i) % 4 == 1 ) { system.Erase(handle); } }
+	check( system.Size() == 300 && system.Maintain(0) == 0 ); //filled at the end of each archetype
+	num = 0;
+	for( auto [handle, i] : system.template GetView<vecs::Handle, int>() ) { check( (-i) % 4 == 3 ); ++num; }
+	check( num == 300 );
+}
+
+
+void test_fixed_capacity() {
+	{
+		vecs::Registry system(1000, 4);
+		std::vector<vecs::Handle> handles;
+		for( int i=0; i<1000; ++i ) { handles.push_back( system.Insert(i, (float)i) ); }
+		check( std::ranges::all_of(handles, [](auto h){ return h.IsValid(); }) );
+		check( !system.Insert(1000, 1000.0f).IsValid() && system.Size() == 1000 );
+		
+		system.Erase(handles[0]); //warm up, fills the scratch vectors and the view pool
+		handles[0] = system.Insert(0, 0.0f);
+		for( auto [handle, i, f] : system.template GetView<vecs::Handle, int&, float>() ) { i = (int)f; }
+
+		size_t before = allocations();
+		count_allocations(true);
+		for( int frame=0; frame<10; ++frame ) {
+			for( int i=0; i<200; ++i ) { system.Erase(handles[i * 5]); }
+			for( int i=0; i<200; ++i ) { handles[i * 5] = system.Insert(i * 5, (float)(i * 5)); }
+			for( auto [handle, i, f] : system.template GetView<vecs::Handle, int&, float>() ) { i = i + 1; }
+		}
+		count_allocations(false);
+		check( allocations() == before );
+		check( system.Size() == 1000 && system.Get<int>(handles[5]) == 5 + 1 && system.Get<int>(handles[6]) == 6 + 10 );
+		system.Validate();
+	}
+	{
+		vecs::Registry system(100, 2);
+		auto h1 = system.Insert(1, 1.0f);
+		auto h2 = system.Insert(2.0);
+		check( h1.IsValid() && h2.IsValid() );
+		check( !system.Insert('a').IsValid() ); //third archetype
+		check( !system.Put(h1, 'a') && system.Get<int>(h1) == 1 && !system.Has<char>(h1) );
+		check( !system.AddTags(h2, 1ull) && system.Put(h2, 3.0) && system.Get<double>(h2) == 3.0 );
+	}
+}
+
+void test_index() {
+	vecs::Registry system;
+	auto h1 = system.Insert(1, std::string("one"));
+	auto h2 = system.Insert(2, std::string("two"), 2.0f);
+	auto& names = system.CreateIndex<std::string>(true);
+	auto& ints = system.CreateIndex<int>();
+	check( &system.CreateIndex<std::string>() == &names && names.IsUnique() && !ints.IsUnique() );
+	check( names.Size() == 2 && system.Find(std::string("two")).GetValue() == h2.GetValue() );
+
+	auto h3 = system.Insert(2, std::string("three"));
+	check( system.FindAll(2).size() == 2 && system.Find(std::string("three")).GetValue() == h3.GetValue() );
+
+	system.Put(h1, 3);
+	check( system.FindAll(1).empty() && system.FindAll(3).size() == 1 );
+	system.Get<int&>(h3) = 3;
+	check( system.FindAll(2).size() == 1 && system.FindAll(3).size() == 2 );
+	check( system.AddTags(h2, 1ull) && system.Find(std::string("two")).GetValue() == h2.GetValue() );
+	system.Put(h2, 'a'); //moves the entity
+	check( system.Find(2).GetValue() == h2.GetValue() && ints.Size() == 3 );
+
+	system.Erase(h1);
+	check( system.FindAll(3).size() == 1 && !system.Find(std::string("one")).IsValid() );
+	system.Erase<std::string>(h3);
+	check( names.Size() == 1 && !system.Find(std::string("three")).IsValid() && system.Find(3).GetValue() == h3.GetValue() );
+	system.Put(h3, std::string("three"));
+	check( system.Find(std::string("three")).GetValue() == h3.GetValue() );
+
+	system.Clear();
+	check( names.Size() == 0 && ints.Size() == 0 );
+}
+
+void test_ordered_index() {
+	vecs::Registry system;
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<5000; ++i ) { handles.push_back( system.Insert((i * 7919) % 1000, (float)i) ); }
+	auto& health = system.CreateOrderedIndex<int>();
+	check( &system.CreateOrderedIndex<int>() == &health && health.Size() == 5000 );
+
+	auto brute = [&](int lo, int hi) { 
+		size_t n = 0;
+		for( auto [handle, i] : system.template GetView<vecs::Handle, int>() ) { if( lo <= i && i < hi ) ++n; }
+		return n;
+	};
+	auto sorted = [&](const std::vector<vecs::Handle>& hs) {
+		return std::ranges::is_sorted(hs, {}, [&](auto h) { return system.Get<int>(h); });
+	};
+	auto below = system.FindRange<int>({}, 20);
+	check( below.size() == 100 && below.size() == brute(0, 20) && sorted(below) );
+	check( system.FindRange<int>(100, 200).size() == brute(100, 200) && system.FindRange<int>(990, {}).size() == 50 );
+
+	for( int i=0; i<5000; i+=2 ) { system.Erase(handles[i]); }
+	for( int i=1; i<5000; i+=4 ) { system.Put(handles[i], 2000 + i); }
+	for( int i=3; i<5000; i+=4 ) { system.Get<int&>(handles[i]) = 500; }
+	auto all = system.FindRange<int>({}, {});
+	check( all.size() == 2500 && health.Size() == 2500 && sorted(all) );
+	check( system.FindRange<int>(500, 501).size() == 1250 && system.FindRange<int>(0, 500).empty() );
+	check( system.FindRange<int>(2000, 3000).size() == brute(2000, 3000) );
+
+	size_t chunks = 0, n = 0;
+	health.ForEachChunk(2000, {}, [&](std::span<const int> values, std::span<const vecs::Handle> hs) { 
+		++chunks; n += values.size(); 
+		check( values.size() == hs.size() && system.Get<int>(hs.front()) == values.front() );
+	});
+	check( n == 1250 && chunks > 1 );
+
+	for( int i=1; i<5000; i+=2 ) { system.Erase(handles[i]); }
+	check( health.Size() == 0 && system.FindRange<int>({}, {}).empty() );
+	(void)system.Insert(1, 1.0f);
+	check( system.FindRange<int>(0, 2).size() == 1 );
+}
+
+struct Position { float x, y, z; };
+
+void test_spatial_index() {
+	vecs::Registry system;
+	std::vector<vecs::Handle> handles;
+	for( int x=0; x<20; ++x ) {
+		for( int y=0; y<20; ++y ) { handles.push_back( system.Insert(Position{(float)x, (float)y, 0.0f}, x * 20 + y) ); }
+	}
+	(void)system.Insert(std::array<float, 2>{1.0f, 1.0f});
+	auto& grid = system.CreateSpatialIndex<Position>(2.0f);
+	check( &system.CreateSpatialIndex<Position>(1.0f) == &grid && grid.Size() == 400 );
+
+	auto brute = [&](Position c, float r) {
+		size_t n = 0;
+		for( auto p : system.template GetView<Position>() ) {
+			if( (p.x-c.x)*(p.x-c.x) + (p.y-c.y)*(p.y-c.y) + (p.z-c.z)*(p.z-c.z) <= r*r ) ++n;
+		}
+		return n;
+	};
+	check( system.FindInRadius(Position{10, 10, 0}, 1.0f).size() == 5 );
+	check( system.FindInRadius(Position{5.5f, 7.2f, 0}, 3.7f).size() == brute({5.5f, 7.2f, 0}, 3.7f) );
+	check( system.FindInRadius(Position{-5, -5, 0}, 100.0f).size() == 400 );
+	check( system.FindInBox(Position{-1, -1, -1}, Position{2, 3, 1}).size() == 12 );
+
+	system.Put(handles[0], Position{100, 100, 5}); //moves to a far cell
+	system.Get<Position&>(handles[1]) = Position{-50, 0, 0};
+	check( system.FindInBox(Position{-1, -1, -1}, Position{2, 3, 1}).size() == 10 );
+	auto far = system.FindInRadius(Position{100, 100, 5}, 0.5f);
+	check( far.size() == 1 && far[0].GetValue() == handles[0].GetValue() );
+	check( system.FindInRadius(Position{-50, 0, 0}, 0.5f).size() == 1 );
+
+	system.Erase(handles[0]);
+	system.Erase<Position>(handles[1]);
+	check( grid.Size() == 398 && system.FindInRadius(Position{100, 100, 5}, 1.0f).empty() && system.FindInRadius(Position{-50, 0, 0}, 1.0f).empty() );
+
+	auto& grid2 = system.CreateSpatialIndex<std::array<float, 2>>(1.0f);
+	check( grid2.Size() == 1 && system.FindInRadius(std::array<float, 2>{0.0f, 0.0f}, 1.5f).size() == 1 );
+}
+
+void test_aggregate() {
+	vecs::Registry system;
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<100; ++i ) { handles.push_back( system.Insert(i, (float)i) ); }
+	auto& ints = system.CreateAggregate<int>();
+	auto& enemies = system.CreateAggregate<int, float>({1ull}, {2ull});
+	check( &system.CreateAggregate<int, float>({1ull}, {2ull}) == &enemies && &system.CreateAggregate<int>() == &ints );
+	check( ints.Count() == 100 && ints.Sum() == 4950 && ints.Min() == 0 && ints.Max() == 99 && enemies.Count() == 0 );
+
+	for( int i=0; i<10; ++i ) { system.AddTags(handles[i], 1ull); }
+	check( enemies.Count() == 10 && enemies.Sum() == 45 && enemies.Max() == 9 );
+	system.AddTags(handles[9], 2ull);
+	system.Put(handles[0], 50);
+	check( enemies.Count() == 9 && enemies.Sum() == 86 && enemies.Min() == 1 && enemies.Max() == 50 );
+	system.Get<int&>(handles[1]) = -5;
+	system.Erase<float>(handles[2]);
+	check( enemies.Count() == 8 && enemies.Min() == -5 && enemies.Sum() == 78 && ints.Min() == -5 );
+
+	system.Erase(handles[99]);
+	(void)system.Insert(1000);
+	check( ints.Count() == 100 && ints.Max() == 1000 && ints.Sum() == 4950 + 50 - 6 - 99 + 1000 );
+	system.Clear();
+	check( ints.Count() == 0 && !ints.Max().has_value() && ints.Sum() == 0 && enemies.Count() == 0 );
+	auto& strings = system.CreateAggregate<std::string>();
+	(void)system.Insert(std::string("b"));
+	(void)system.Insert(std::string("a"));
+	check( strings.Count() == 2 && strings.Min() == "a" );
+
+	auto& ints2 = system.CreateAggregate<int>();
+	auto h = system.Insert(7);
+	system.Get<int&>(h)() = 99; //writes through operator() are not seen by the aggregate
+	system.Erase(h);
+	check( ints2.Count() == 0 && ints2.Sum() == -92 );
+}
+
+void test_reduce() {
+	vecs::Registry system;
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<100000; ++i ) { 
+		if( i % 3 == 0 ) handles.push_back( system.Insert(i, (float)i * 0.1f) ); 
+		else handles.push_back( system.Insert(i, (float)i * 0.1f, 'a') ); 
+	}
+	check( system.GetView<int>().Count() == 100000 && system.GetView<int, char>().Count() == 66666 );
+	check( system.GetView<int>({}, {vecs::Type<char>()}).Count() == 33334 && system.GetView<double>().Count() == 0 );
+
+	auto sum = system.GetView<int>().Reduce<int64_t>(0, [](int i) { return (int64_t)i; }, std::plus<int64_t>{});
+	check( sum == 4999950000ll );
+	auto view = system.GetView<vecs::Handle, float>();
+	auto add = [](float a, float b) { return a + b; };
+	auto f1 = view.Reduce<float>(0.0f, [](vecs::Handle, float f) { return f; }, add);
+	auto f2 = view.Reduce<float>(0.0f, [](vecs::Handle, float f) { return f; }, add, 1000);
+	auto f3 = view.Reduce<float>(0.0f, [](vecs::Handle, float f) { return f; }, add);
+	check( f1 == f3 && std::abs(f1 - f2) < f1 * 1e-3f );
+	auto max = view.Reduce<float>(0.0f, [](vecs::Handle, float f) { return f; }, [](float a, float b) { return std::max(a, b); });
+	check( max == 99999 * 0.1f );
+
+	system.SetDeferredCompaction(true);
+	for( int i=0; i<100000; i+=2 ) { system.Erase(handles[i]); }
+	check( system.GetView<int>().Count() == 50000 );
+	check( system.GetView<int>().Reduce<int64_t>(0, [](int i) { return (int64_t)i; }, std::plus<int64_t>{}) == 2500000000ll );
+	system.SetDeferredCompaction(false);
+}
+
+void test_relationships() {
+	vecs::Registry system;
+	auto root = system.Insert(0);
+	auto a = system.Insert(1);
+	auto b = system.Insert(2);
+	auto c = system.Insert(3, 3.0f);
+	auto d = system.Insert(4);
+	check( system.SetParent(a, root) && system.SetParent(b, root) && system.SetParent(c, a) && system.SetParent(d, root, false) );
+	check( system.GetParent(c).GetValue() == a.GetValue() && !system.GetParent(root).IsValid() );
+	auto children = system.GetChildren(root);
+	check( children.size() == 3 && children[0].GetValue() == a.GetValue() && children[2].GetValue() == d.GetValue() );
+	check( !system.SetParent(root, c) && !system.SetParent(a, a) ); //cycles
+
+	system.Put(c, 3.5); //moves the child to another archetype
+	system.SetParent(b, a);
+	check( system.GetChildren(root).size() == 2 && system.GetChildren(a).size() == 2 && system.GetParent(b).GetValue() == a.GetValue() );
+	check( system.SetParent(b, {}) && !system.Has<vecs::ChildOf>(b) && system.GetChildren(a).size() == 1 );
+
+	system.Erase(root); //erases a and c, orphans d
+	check( !system.Exists(a) && !system.Exists(c) && system.Exists(b) && system.Exists(d) );
+	check( !system.Has<vecs::ChildOf>(d) && system.GetChildren(root).empty() && system.GetChildren(a).empty() && system.Size() == 2 );
+	check( !system.SetParent(a, {}) && !system.SetParent(c, b) && system.GetChildren(b).empty() ); //erased children
+}
+
+struct LocalOffset { float x; };
+struct WorldOffset { float x; };
+
+void test_propagate() {
+	vecs::Registry system;
+	auto combine = [](const WorldOffset* parent, const LocalOffset& local) { return WorldOffset{ (parent ? parent->x : 0.0f) + local.x }; };
+	std::vector<vecs::Handle> handles; //a forest of 10 trees, each a chain of depth 100 with a leaf at each node
+	for( int t=0; t<10; ++t ) {
+		vecs::Handle parent{};
+		for( int d=0; d<100; ++d ) {
+			auto node = system.Insert(LocalOffset{1.0f}, WorldOffset{0.0f});
+			auto leaf = system.Insert(LocalOffset{0.5f}, WorldOffset{0.0f});
+			if( parent.IsValid() ) system.SetParent(node, parent);
+			system.SetParent(leaf, node);
+			handles.push_back(node);
+			parent = node;
+		}
+	}
+	auto other = system.Insert(LocalOffset{7.0f}); //no world component
+	check( system.Propagate<LocalOffset, WorldOffset>(combine) == 2000 );
+	check( system.Get<WorldOffset>(handles[99]).x == 100.0f && system.Get<WorldOffset>(system.GetChildren(handles[99])[0]).x == 100.5f );
+	check( system.Propagate<LocalOffset, WorldOffset>(combine) == 0 );
+
+	auto snapshot = system.Snapshot();
+	system.Put(handles[150], LocalOffset{2.0f}); //tree 1, depth 50
+	check( system.Propagate<LocalOffset, WorldOffset>(combine) == 100 );
+	check( system.Get<WorldOffset>(handles[199]).x == 101.0f && system.Get<WorldOffset>(handles[149]).x == 50.0f );
+	check( snapshot.Get<WorldOffset>(handles[199]).x == 100.0f );
+
+	system.Get<LocalOffset&>(handles[0]) = LocalOffset{3.0f};
+	system.SetParent(handles[100], handles[50]); //tree 1 becomes a subtree of tree 0
+	system.Erase(handles[10]); //cuts tree 0 at depth 10
+	(void)system.Insert(LocalOffset{1.0f}, WorldOffset{0.0f});
+	system.Propagate<LocalOffset, WorldOffset>(combine);
+	check( system.Get<WorldOffset>(handles[9]).x == 12.0f && !system.Exists(handles[50]) && !system.Exists(handles[199]) );
+	check( system.Get<WorldOffset>(handles[299]).x == 100.0f && system.Get<LocalOffset>(other).x == 7.0f );
+	system.Validate();
+}
+
+struct Damage { vecs::Handle m_target; int m_amount; };
+
+void test_events() {
+	vecs::Registry system;
+	auto target = system.Insert(100);
+	system.Emit(Damage{target, 10});
+	system.Emit(Damage{target, 5});
+	check( system.GetEvents<Damage>().empty() );
+	system.FlushEvents();
+	auto events = system.GetEvents<Damage>();
+	check( events.size() == 2 && events[0].m_amount == 10 && events[1].m_amount == 5 );
+
+	auto& channel = system.GetChannel<Damage>();
+	check( &channel == &system.GetChannel<Damage>() );
+	const int threads = vecs::LOCKGUARDTYPE == vecs::LOCKGUARDTYPE_PARALLEL ? 8 : 1, num = 10000;
+	std::vector<std::jthread> workers;
+	for( int t=0; t<threads; ++t ) {
+		workers.emplace_back( [&, t]() { for( int i=0; i<num; ++i ) { channel.Emit(Damage{target, t * num + i}); } } );
+	}
+	workers.clear();
+	system.FlushEvents();
+	events = system.GetEvents<Damage>();
+	std::vector<int> amounts;
+	for( auto& e : events ) { amounts.push_back(e.m_amount); }
+	std::ranges::sort(amounts);
+	check( events.size() == threads * num && amounts.front() == 0 && amounts.back() == threads * num - 1 );
+	check( std::adjacent_find(amounts.begin(), amounts.end()) == amounts.end() );
+
+	system.Emit(std::string("hello"));
+	system.FlushEvents();
+	check( system.GetEvents<Damage>().empty() && system.GetEvents<std::string>()[0] == "hello" );
+	system.GetChannel<std::string>().Clear();
+	check( system.GetEvents<std::string>().empty() );
+}
+
+void test_timers() {
+	vecs::Registry system;
+	std::vector<vecs::Handle> handles;
+	for( int i=0; i<1000; ++i ) { handles.push_back( system.Insert(i, (float)i) ); }
+	for( int i=0; i<1000; ++i ) { system.EraseAfter(handles[i], i + 1); }
+	system.RemoveComponentAfter<float>(handles[500], 10);
+	system.RemoveComponentAfter<double>(handles[501], 10);
+	system.EraseAfter(handles[999], 100000); //far in the future, after its first erasure
+	check( system.Tick() == 1 && !system.Exists(handles[0]) && system.Exists(handles[1]) );
+	for( int t=2; t<=10; ++t ) { system.Tick(); }
+	check( system.Size() == 990 && !system.Has<float>(handles[500]) && system.Has<float>(handles[501]) );
+
+	for( int t=11; t<=1000; ++t ) { system.Tick(); }
+	check( system.Size() == 0 );
+	auto h = system.Insert(1);
+	system.EraseAfter(h, 300);
+	for( int t=0; t<299; ++t ) { system.Tick(); }
+	check( system.Exists(h) );
+	system.Tick();
+	check( !system.Exists(h) );
+	for( int t=1300; t<100001; ++t ) { system.Tick(); } //the late erasure of handles[999] is ignored
+	check( system.Size() == 0 );
+	system.Validate();
+}
+
+void test_builder() {
+	vecs::Registry system;
+	auto h1 = system.Build().Put(1).Put(2.0f).AddTags(1ull, 2ull).Commit();
+	check( h1.IsValid() && system.Get<int>(h1) == 1 && system.Get<float>(h1) == 2.0f && system.Types(h1).size() == 5 );
+	check( !system.Build().AddTags(1ull).Commit().IsValid() );
+
+	auto& index = system.CreateIndex<int>();
+	auto h2 = system.Insert(5, std::string("abc"));
+	auto builder = system.Build(h2).Put(6).Put(3.0).Put('c');
+	builder.Erase<std::string>().AddTags(3ull);
+	check( builder.Commit().GetValue() == h2.GetValue() );
+	check( system.Get<int>(h2) == 6 && system.Get<double>(h2) == 3.0 && system.Get<char>(h2) == 'c' && !system.Has<std::string>(h2) );
+	check( system.Find(6).GetValue() == h2.GetValue() && !system.Find(5).IsValid() && index.Size() == 2 );
+	check( system.Build(h2).Put(7).Commit().IsValid() && system.Get<int>(h2) == 7 && system.Find(7).IsValid() ); //no move
+
+	system.Build(h2).EraseTags(3ull).Erase<char>().Commit();
+	check( system.Types(h2).size() == 3 && system.Get<int>(h2) == 7 );
+	system.Erase(h2);
+	check( !system.Build(h2).Put(1).Commit().IsValid() && system.Size() == 1 );
+	system.Validate();
+}
+
+struct Counted { 
+	inline static int m_constructed = 0;
+	int m_a{0}; std::string m_b; 
+	Counted() { ++m_constructed; }
+	Counted(int a, std::string b) : m_a{a}, m_b{std::move(b)} { ++m_constructed; }
+	Counted(const Counted& other) = default;
+	Counted(Counted&& other) = default;
+	auto operator=(const Counted&) -> Counted& = default;
+	auto operator=(Counted&&) -> Counted& = default;
+};
+
+void test_emplace() {
+	vecs::Registry system;
+	auto h0 = system.Insert(Counted{}, 1); //creates the archetype and its first segment
+	int before = Counted::m_constructed;
+	auto h1 = system.Emplace<Counted, int>(std::forward_as_tuple(5, "abc"), std::make_tuple(7));
+	check( Counted::m_constructed == before + 1 ); //no temporary value
+	check( system.Get<Counted>(h1).m_a == 5 && system.Get<Counted>(h1).m_b == "abc" && system.Get<int>(h1) == 7 );
+
+	auto h2 = system.Insert(3.0);
+	check( system.Emplace<Counted>(h2, 6, "def") && system.Get<Counted>(h2).m_b == "def" && system.Get<double>(h2) == 3.0 );
+	check( system.Emplace<Counted>(h2, 7, "ghi") && system.Get<Counted>(h2).m_a == 7 );
+	check( system.Emplace<std::string>(h0, 3, 'x') && system.Get<std::string>(h0) == "xxx" );
+
+	vecs::Vector<std::string> vec;
+	vec.emplace_back(2, 'a');
+	vec.emplace_back("b");
+	check( vec.size() == 2 && vec[0] == "aa" && vec[1] == "b" );
+	system.Validate();
+}
+
+struct Live { 
+	inline static int m_live = 0;
+	std::shared_ptr<int> m_ptr;
+	Live() { ++m_live; }
+	Live(int v) : m_ptr{std::make_shared<int>(v)} { ++m_live; }
+	Live(const Live& other) : m_ptr{other.m_ptr} { ++m_live; }
+	Live(Live&& other) : m_ptr{std::move(other.m_ptr)} { ++m_live; }
+	~Live() { --m_live; }
+	auto operator=(const Live&) -> Live& = default;
+	auto operator=(Live&&) -> Live& = default;
+};
+
+void test_vector_lifetime() {
+	{
+		vecs::Vector<Live> vec;
+		vec.reserve(1000);
+		check( Live::m_live == 0 ); //allocating segments constructs nothing
+		for( int i = 0; i < 200; ++i ) vec.emplace_back(i);
+		check( Live::m_live == 200 );
+		auto ptr = vec[199].m_ptr;
+		vec.pop_back();
+		check( Live::m_live == 199 && ptr.use_count() == 1 ); //popped values are destroyed
+		vec.erase(0);
+		check( Live::m_live == 198 && *vec[0].m_ptr == 198 );
+
+		auto snap = vec.snapshot();
+		vec.erase(5);
+		vec.push_back(Live{7});
+		check( Live::m_live == 198 + 64 + 6 ); //the two written segments were cloned
+		check( snap->size() == 198 && vec.size() == 198 );
+		snap.reset();
+		check( Live::m_live == 198 );
+		vec.clear();
+		check( Live::m_live == 0 );
+		for( int i = 0; i < 100; ++i ) vec.emplace_back(i);
+	}
+	check( Live::m_live == 0 );
+}
+
+void test_get_many() {
+	vecs::Registry system;
+	std::vector<vecs::Handle> handles;
+	for( int i = 0; i < 300; ++i ) {
+		if( i % 3 == 0 ) handles.push_back( system.Insert(i, 1.0f * i) );
+		else if( i % 3 == 1 ) handles.push_back( system.Insert(i, 1.0f * i, 'a') );
+		else handles.push_back( system.Insert(i) );
+	}
+	std::ranges::reverse(handles);
+	auto erased = handles[10];
+	system.Erase(erased);
+
+	std::vector<int> ints(handles.size(), -1);
+	check( system.GetMany<int>(handles, std::span{ints}) == handles.size() - 1 );
+	check( ints[10] == -1 );
+	bool ok = true;
+	for( size_t i = 0; i < handles.size(); ++i ) { if( i != 10 && ints[i] != system.Get<int>(handles[i]) ) ok = false; }
+	check( ok );
+
+	std::vector<std::tuple<int, float>> values(handles.size(), {-1, -1.0f});
+	check( system.GetMany<int, float>(handles, std::span{values}) == 199 );
+	for( size_t i = 0; i < handles.size(); ++i ) { 
+		if( i == 10 || !system.Has<float>(handles[i]) ) { if( std::get<0>(values[i]) != -1 ) ok = false; }
+		else if( std::get<0>(values[i]) != system.Get<int>(handles[i]) || std::get<1>(values[i]) != system.Get<float>(handles[i]) ) ok = false; 
+	}
+	check( ok );
+
+	std::vector<vecs::Handle> invalid{ handles[0], vecs::Handle{} };
+	std::vector<int> out(2, -1);
+	check( system.GetMany<int>(invalid, std::span{out}) == 1 && out[0] == system.Get<int>(handles[0]) && out[1] == -1 );
+	check( system.PutMany<int>(invalid, std::vector<int>{7, 8}) == 1 && system.Get<int>(handles[0]) == 7 );
+	system.Validate();
+}
+
+void test_put_many() {
+	vecs::Registry system;
+	system.CreateIndex<float>();
+	std::vector<vecs::Handle> handles;
+	for( int i = 0; i < 300; ++i ) {
+		if( i % 3 == 0 ) handles.push_back( system.Insert(i, 1.0f) );
+		else if( i % 3 == 1 ) handles.push_back( system.Insert(i, 'a') );
+		else handles.push_back( system.Insert(i) );
+	}
+	std::ranges::reverse(handles);
+	auto erased = handles[10];
+	system.Erase(erased);
+	handles.push_back(handles[20]); //duplicate, the last value wins
+
+	std::vector<float> values;
+	for( size_t i = 0; i < handles.size(); ++i ) values.push_back( 2.0f * i );
+	check( system.PutMany<float>(handles, values) == handles.size() - 1 );
+	bool ok = true;
+	for( size_t i = 0; i < handles.size() - 1; ++i ) {
+		if( i == 10 ) continue;
+		if( i == 20 ) { if( system.Get<float>(handles[i]) != 2.0f * (handles.size() - 1) ) ok = false; continue; }
+		if( system.Get<float>(handles[i]) != 2.0f * i || !system.Has<int>(handles[i]) ) ok = false;
+	}
+	check( ok );
+	check( system.Find<float>(4.0f).GetValue() == handles[2].GetValue() );
+	check( system.GetView<float>().Count() == 299 );
+	system.Validate();
+
+	//moves into a full archetype fill its gaps, which moves entities of the archetype's own group
+	vecs::Registry fixed(32);
+	fixed.SetDeferredCompaction(true);
+	std::vector<vecs::Handle> moved, full, batch;
+	for( int i = 0; i < 32; ++i ) { full.push_back( fixed.Insert(i) ); check( fixed.Put(full[i], 0.0f) ); }
+	for( int i = 0; i < 16; ++i ) { fixed.Erase(full[i]); moved.push_back( fixed.Insert(100 + i) ); }
+	for( int i = 0; i < 16; ++i ) { batch.push_back(moved[i]); batch.push_back(full[16 + i]); }
+	std::vector<float> floats;
+	for( auto h : batch ) floats.push_back( (float)fixed.Get<int>(h) );
+	check( fixed.PutMany<float>(batch, floats) == batch.size() );
+	ok = true;
+	for( auto h : batch ) { if( fixed.Get<float>(h) != (float)fixed.Get<int>(h) ) ok = false; }
+	check( ok );
+	fixed.Validate();
+}
+
+void test_runtime_components() {
+	int live = Live::m_live;
+	{
+		vecs::Registry system;
+		auto hp = system.RegisterComponent({"health", sizeof(float), alignof(float)});
+		auto name = system.RegisterComponent(vecs::ComponentDescriptor::Of<std::string>("name"));
+		auto res = system.RegisterComponent(vecs::ComponentDescriptor::Of<Live>("resource"));
+		check( hp != name && hp != vecs::Type<float>() && system.RegisterComponent({"health", sizeof(float), alignof(float)}) == hp );
+		check( system.GetDescriptor(name)->m_size == sizeof(std::string) );
+
+		std::vector<vecs::Handle> handles;
+		for( int i = 0; i < 200; ++i ) {
+			auto h = system.Insert(i);
+			float health = 1.0f * i;
+			check( system.PutRaw(h, hp, &health) );
+			if( i % 2 == 0 ) { std::string str = std::to_string(i); check( system.PutRaw(h, name, &str) ); }
+			handles.push_back(h);
+		}
+		check( *static_cast<float*>(system.GetRaw(handles[7], hp)) == 7.0f && system.GetRaw(handles[7], name) == nullptr );
+		check( *static_cast<std::string*>(system.GetRaw(handles[8], name)) == "8" && system.Get<int>(handles[8]) == 8 );
+
+		for( int i = 0; i < 200; i += 10 ) { system.Erase(handles[i]); }
+		check( system.EraseTags(handles[12], name) && system.GetRaw(handles[12], name) == nullptr );
+		check( *static_cast<float*>(system.GetRaw(handles[12], hp)) == 12.0f );
+		check( system.AddTags(handles[13], name) && static_cast<std::string*>(system.GetRaw(handles[13], name))->empty() );
+
+		size_t count = 0; bool ok = true;
+		std::vector<size_t> ids{hp, name};
+		system.GetView<int>({hp, name}).ForEachRaw(ids, [&](int& i, std::span<void* const> values) {
+			if( *static_cast<float*>(values[0]) != 1.0f * i ) ok = false;
+			if( i != 13 && *static_cast<std::string*>(values[1]) != std::to_string(i) ) ok = false;
+			++count;
+		});
+		check( ok && count == 100 - 20 - 1 + 1 ); //even, not erased, 12 without and 13 with name
+		check( system.GetView<vecs::Handle>({hp}).Count() == 180 );
+
+		Live value{5};
+		check( system.PutRaw(handles[1], res, &value) && Live::m_live == live + 2 );
+		auto h = system.Build().Put(3).AddTags(res).Commit();
+		check( static_cast<Live*>(system.GetRaw(h, res))->m_ptr == nullptr && system.Get<int>(h) == 3 );
+		check( Live::m_live == live + 3 );
+		system.Erase(handles[1]);
+		check( Live::m_live == live + 2 );
+		system.Validate();
+	}
+	check( Live::m_live == live );
+	{	//large values are swapped through the scratch value, values with copy function are hashed by their hash function
+		struct big_t { std::string m_str; char m_pad[100]{}; };
+		std::shared_ptr<const vecs::ComponentDescriptor> big = std::make_shared<vecs::ComponentDescriptor>(vecs::ComponentDescriptor::Of<big_t>("big"));
+		vecs::RawVector vec{big};
+		big_t a{"a", {}}, b{"b", {}};
+		vec.push_back(&a);
+		vec.push_back(&b);
+		vec.swap(0, 1);
+		check( static_cast<big_t*>(vec[0])->m_str == "b" && static_cast<big_t*>(vec[1])->m_str == "a" );
+
+		std::shared_ptr<const vecs::ComponentDescriptor> str = std::make_shared<vecs::ComponentDescriptor>(vecs::ComponentDescriptor::Of<std::string>("str"));
+		vecs::RawVector v1{str}, v2{str};
+		std::string s = "x";
+		v1.push_back(&s);
+		v2.push_back(&s);
+		check( str->m_hash != nullptr && v1.checksum(0) == v2.checksum(0) );
+		*static_cast<std::string*>(v2[0]) = "y";
+		check( v1.checksum(0) != v2.checksum(0) );
+	}
+}
+
+
 size_t test_insert_iterate( vecs::Registry& system, int m ) {
 
 	auto t1 = std::chrono::high_resolution_clock::now();
@@ -517,6 +1392,28 @@ void test5() {
 
 void test_vecs() {
 	test1();
+	test_read_mostly();
+	test_double_buffered();
+	test_snapshot();
+	test_rewind();
+	test_checksum();
+	test_maintain();
+	test_fixed_capacity();
+	test_index();
+	test_ordered_index();
+	test_spatial_index();
+	test_aggregate();
+	test_reduce();
+	test_relationships();
+	test_propagate();
+	test_events();
+	test_timers();
+	test_builder();
+	test_emplace();
+	test_vector_lifetime();
+	test_get_many();
+	test_put_many();
+	test_runtime_components();
 	
 	test3( "Insert", false, [&](auto& system, int num){ return test_insert(system, num); } );
 	test3( "Iterate", true, [&](auto& system, int num){ return test_iterate(system, num); } );